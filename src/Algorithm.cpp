@@ -22,10 +22,13 @@
  * SOFTWARE.
  */
 #include "Algorithm.h"
+#include "Island.h"
+#include "Memory.h"
 #include "Polygon.h"
 #include "Print.h"
 #include "Random.h"
 #include "Statistics.h"
+#include "Trace.h"
 #include <algorithm>
 #include <cassert>
 #include <cfloat>
@@ -35,23 +38,128 @@
 #include <iostream>
 #include <limits>
 #include <queue>
+#include <thread>
 
 using namespace std;
 
-Algorithm alg;
+namespace {
+/* Settings that are fixed for the whole run. The kernels are instantiated
+ * for every combination, so these are resolved at compile time instead of
+ * in the innermost loops. */
+template <bool Length, bool Width, bool Compaction, bool RectangularPlate,
+          bool BB>
+struct KernelPolicy {
+  static const bool optimizeLength = Length;
+  static const bool optimizeWidth = Width;
+  static const bool optimizeCompaction = Compaction;
+  static const bool plateIsRectangle = RectangularPlate;
+  static const bool useBB = BB;
+};
 
-bool Algorithm::isFeasible(const Polygon& pol) const {
-  /* Test 1. plate test: test if every vertex in pol is inside plate
-   * TODO: optimize for when plate is a rectangle */
+/* Turns the runtime flags, one at a time, into template arguments */
+template <bool... Flags> struct KernelBinder {
+  template <typename... Rest>
+  static void bind(Algorithm& a, bool flag, Rest... rest) {
+    if (flag) {
+      KernelBinder<Flags..., true>::bind(a, rest...);
+    } else {
+      KernelBinder<Flags..., false>::bind(a, rest...);
+    }
+  }
+
+  static void bind(Algorithm& a) {
+    typedef KernelPolicy<Flags...> P;
+    a.selectKernel = &Algorithm::selectPiecePlacementKernel<P>;
+    a.feasibleKernel = &Algorithm::isFeasibleKernel<P>;
+  }
+};
+} // namespace
+
+void Algorithm::bindKernels() {
+  KernelBinder<>::bind(*this, problem.optimizeLength, problem.optimizeWidth,
+                       problem.optimizeCompaction, problem.plateIsRectangle,
+                       problem.useBB);
+}
+
+namespace {
+/* true if the inner disks of a and b, b moved by d relative to a, overlap;
+ * then so do the pieces */
+bool innerDisksOverlap(const RotatedPiece& a, const RotatedPiece& b,
+                       const Point& d) {
+  Point c = b.innerCenter + d - a.innerCenter;
+  double r = a.innerRadius + b.innerRadius;
+  return c.x * c.x + c.y * c.y < r * r;
+}
+
+/* true if an edge of either hull separates them by more than EPS, b moved
+ * by d relative to a (separating axis test); then the pieces do not
+ * overlap. Hulls that touch or nearly do are left to the exact test. */
+bool hullsSeparated(const vector<Point>& a, const vector<Point>& b,
+                    const Point& d) {
+  for (int side = 0; side < 2; ++side) {
+    const auto& p = side == 0 ? a : b;
+    const auto& q = side == 0 ? b : a;
+    Point offset = side == 0 ? d : -d;
+    int n = p.size();
+    for (int i = 0; i < n; ++i) {
+      const Point& s = p[i];
+      const Point& t = p[(i + 1) % n];
+      /* outward normal of a counterclockwise edge */
+      double nx = t.y - s.y, ny = s.x - t.x;
+      double limit = nx * s.x + ny * s.y + EPS * sqrt(nx * nx + ny * ny);
+      bool separated = true;
+      for (auto& r : q) {
+        if (nx * (r.x + offset.x) + ny * (r.y + offset.y) < limit) {
+          separated = false;
+          break;
+        }
+      }
+      if (separated) return true;
+    }
+  }
+  return false;
+}
+
+/* true if a and b overlap, given that their bounding boxes intersect */
+bool piecesOverlap(const Polygon& a, const Polygon& b) {
+  /* Test 4. polygon intersection: test if any pair of edges intersect */
+  if (edgesIntersect(a, b)) return true;
+
+  /* Test 3. point inclusion: test if no points in a are inside b */
+  for (auto& p : a.v)
+    if (b.pointInside(p, false)) {
+      return true;
+    }
+  for (auto& p : b.v)
+    if (a.pointInside(p, false)) {
+      return true;
+    }
+
+  /* Test 4. polygon equal */
+  return a == b;
+}
+} // namespace
+
+template <typename Policy>
+bool Algorithm::isFeasibleKernel(const Polygon& pol, int type,
+                                 int angle) const {
+  MEMORY_PHASE(Feasibility);
+  /* Test 1. plate test: test if every vertex in pol is inside plate. If the
+   * plate is a rectangle, it suffices to test the bounding box of pol */
   ++statistics.numFeasabilityTests;
 
-  for (auto& p : pol.v) {
-    if (problem.plateIsRectangle and
-        not pointInRectangle(p, problem.plateLeft, problem.plateRight,
-                             problem.plateTop, problem.plateBottom)) {
-      return false;
-    } else if (not problem.plate.pointInside(p, true)) {
+  if (Policy::plateIsRectangle) {
+    auto& bb = const_cast<Polygon&>(pol).get_bb();
+    if (bb.left < problem.plateLeft - EPS or
+        bb.right > problem.plateRight + EPS or
+        bb.bottom < problem.plateBottom - EPS or
+        bb.top > problem.plateTop + EPS)
       return false;
+  } else {
+    for (auto& p : pol.v) {
+      if (not problem.plate.pointInside(p, true)) {
+        return false;
+      }
     }
   }
 
@@ -60,7 +168,7 @@ bool Algorithm::isFeasible(const Polygon& pol) const {
 
     /* Test 2. bounds test: if the bounding boxes of pol and qol do not
      * intersect, then ok. This is just an optimization */
-    if (problem.useBB) {
+    if (Policy::useBB) {
       ++statistics.numBBTests;
       if (not boundingBoxesIntersect(pol, polF)) {
         ++statistics.numBBTestsSucceeded;
@@ -68,50 +176,75 @@ bool Algorithm::isFeasible(const Polygon& pol) const {
       }
     }
 
-    /* Test 4. polygon intersection: test for every pair of lines if they
-     * intersect */
-    for (int k = 0; k < (int)pol.v.size(); ++k) {
-      auto &p1 = pol.v[k], &q1 = pol.v[(k + 1) % pol.v.size()];
-      for (int j = 0; j < (int)polF.v.size(); ++j) {
-        auto& p2 = polF.v[j];
-        auto& q2 = polF.v[(j + 1) % polF.v.size()];
-        if (lineSegmentsIntersect(p1, q1, p2, q2)) {
-          return false;
-        }
-      }
+    ++statistics.numPairTests;
+    if (type < 0 or fixed[i].orientation < 0) {
+      if (piecesOverlap(pol, polF)) return false;
+      continue;
     }
 
-    /* Test 3. point inclusion: test if no points in pol are inside qol */
-    for (auto& p : pol.v)
-      if (polF.pointInside(p, false)) {
-        return false;
-      }
-    for (auto& p : polF.v)
-      if (pol.pointInside(p, false)) {
-        return false;
-      }
-
-    /* Test 4. polygon equal */
-    if (pol == polF) return false;
+    /* The key holds the pair in a canonical order, and every test runs in
+     * the frame of the key: its second orientation at the origin and the
+     * first one at the quantized offset. The exact test is not translation
+     * invariant, so this makes the answer depend only on the key, whichever
+     * piece was placed first and wherever the pair is. */
+    Point d = pol.treeOffset - polF.treeOffset;
+    RelativePose pose{type,      angle,
+                      fixed[i].id, fixed[i].orientation,
+                      (int64_t)llround(d.x / EPS), (int64_t)llround(d.y / EPS)};
+    if (make_pair(pose.typeA, pose.angleA) > make_pair(pose.typeB, pose.angleB) or
+        (pose.typeA == pose.typeB and pose.angleA == pose.angleB and
+         make_pair(pose.dx, pose.dy) < make_pair(int64_t(0), int64_t(0)))) {
+      swap(pose.typeA, pose.typeB);
+      swap(pose.angleA, pose.angleB);
+      pose.dx = -pose.dx, pose.dy = -pose.dy;
+    }
+    auto it = pairMemo.find(pose);
+    if (it != pairMemo.end()) {
+      ++statistics.numPairMemoHits;
+      if (it->second) return false;
+      continue;
+    }
+    const auto& oA = problem.pieceOrientations[pose.typeA][pose.angleA];
+    const auto& oB = problem.pieceOrientations[pose.typeB][pose.angleB];
+    Point q(pose.dx * EPS, pose.dy * EPS);
+    bool overlap;
+    if (innerDisksOverlap(oA, oB, -q)) {
+      ++statistics.numApproxRejects;
+      overlap = true;
+    } else if (hullsSeparated(oA.hull, oB.hull, -q)) {
+      ++statistics.numApproxAccepts;
+      overlap = false;
+    } else {
+      pairFrame.v.resize(oA.pol.v.size());
+      for (int k = 0; k < (int)oA.pol.v.size(); ++k)
+        pairFrame.v[k] = oA.pol.v[k] + q;
+      pairFrame.edgeTree = oA.pol.edgeTree;
+      pairFrame.treeOffset = oA.pol.treeOffset + q;
+      overlap = piecesOverlap(pairFrame, oB.pol);
+    }
+    if (pairMemo.size() >= maxPairMemo) pairMemo.clear();
+    pairMemo.emplace(pose, overlap);
+    if (overlap) return false;
   }
   return true;
 }
 
-double Algorithm::objective(Polygon& pol) {
+template <typename Policy> double Algorithm::objectiveKernel(Polygon& pol) {
+  MEMORY_PHASE(Objective);
   double r;
   pol.centroid_ = Point::infinity();
 
-  if (problem.optimizeLength && problem.optimizeWidth) {
+  if (Policy::optimizeLength && Policy::optimizeWidth) {
     r = pol.centroid().x / pol.centroid().y;
-  } else if (problem.optimizeWidth) {
+  } else if (Policy::optimizeWidth) {
     r = pol.centroid().y;
-  } else if (problem.optimizeLength) {
+  } else if (Policy::optimizeLength) {
     r = pol.centroid().x;
   } else {
     r = 1;
   }
 
-  if (problem.optimizeCompaction) {
+  if (Policy::optimizeCompaction) {
     auto pts = chFixed.v;
     for (auto& p : pol.v)
       pts.push_back(p);
@@ -127,95 +260,428 @@ double Algorithm::objective(Polygon& pol) {
   return r;
 }
 
-Algorithm::PiecePlacement
-Algorithm::selectPiecePlacement(int floatIndex,
-                                vector<PiecePlacement>* candidates) {
-  const Piece& pc = floating[floatIndex];
-  Polygon pol = pc.pol;
-  PiecePlacement bestPlacement;
-  bestPlacement.value = DBL_MAX;
+namespace {
+/* Appends to 'sectors' the directions around u that point into pol (or out
+ * of it, if 'exterior' is set), as counterclockwise intervals (start,
+ * length) in radians. Points closer than tol to a vertex or an edge are
+ * taken to be on it, since rotated pieces are not placed exactly. */
+void coveredSectors(const Polygon& pol, const Point& u, bool exterior,
+                    double tol, vector<pair<double, double>>& sectors) {
+  int n = pol.v.size();
+  double signedArea = 0;
+  for (int i = 0; i < n; ++i) {
+    const auto &a = pol.v[i], &b = pol.v[(i + 1) % n];
+    signedArea += a.x * b.y - b.x * a.y;
+  }
+  /* the interior of a counterclockwise polygon is left of its edges */
+  bool leftIsInside = (signedArea > 0) != exterior;
+
+  for (int i = 0; i < n; ++i) {
+    const auto& a = pol.v[i];
+    if (distSquared(a, u) < tol * tol) {
+      const auto& next = pol.v[(i + 1) % n];
+      const auto& prev = pol.v[(i + n - 1) % n];
+      double out = atan2(next.y - a.y, next.x - a.x);
+      double in = atan2(prev.y - a.y, prev.x - a.x);
+      double from = leftIsInside ? out : in, to = leftIsInside ? in : out;
+      double len = to - from;
+      if (len <= 0) len += 2 * PI;
+      sectors.emplace_back(from, len);
+      return;
+    }
+  }
+
+  bool inside = false;
+  for (int i = 0, j = n - 1; i < n; j = i++) {
+    const auto &a = pol.v[j], &b = pol.v[i];
+    Point ab = b - a, au = u - a;
+    double len2 = ab.x * ab.x + ab.y * ab.y;
+    double dot = ab.x * au.x + ab.y * au.y;
+    if (std::abs(ab.x * au.y - ab.y * au.x) < tol * sqrt(len2) and dot > 0 and
+        dot < len2) {
+      double dir = atan2(ab.y, ab.x);
+      sectors.emplace_back(leftIsInside ? dir : dir + PI, PI);
+      return;
+    }
+    if ((a.y > u.y) != (b.y > u.y) and
+        u.x < a.x + (u.y - a.y) / (b.y - a.y) * (b.x - a.x))
+      inside = not inside;
+  }
+  if (inside != exterior) sectors.emplace_back(0, 2 * PI);
+}
+
+/* tolerance for deciding whether a vertex touches a piece, relative to the
+ * size of the plate */
+double anchorTolerance(const Polygon& plate) {
+  auto& plateBB = const_cast<Polygon&>(plate).get_bb();
+  return 1e-5 * sqrt(pow(plateBB.right - plateBB.left, 2) +
+                     pow(plateBB.top - plateBB.bottom, 2));
+}
+} // namespace
+
+bool Algorithm::anchorIsDead(const Point& u) const {
+  double tol = anchorTolerance(problem.plate);
+
+  vector<pair<double, double>> sectors;
+  coveredSectors(fixed[0].pol, u, true, tol, sectors);
+  for (int i = 1; i < (int)fixed.size(); ++i) {
+    auto& bb = const_cast<Polygon&>(fixed[i].pol).get_bb();
+    if (u.x < bb.left - tol or u.x > bb.right + tol or u.y < bb.bottom - tol or
+        u.y > bb.top + tol)
+      continue;
+    coveredSectors(fixed[i].pol, u, false, tol, sectors);
+  }
+
+  /* unwrap the intervals into [0, 2pi) and test if their union covers it;
+   * gaps narrower than angleEps cannot hold any vertex of a piece */
+  const double angleEps = 1e-6;
+  vector<pair<double, double>> intervals;
+  for (auto& s : sectors) {
+    double from = fmod(s.first, 2 * PI);
+    if (from < 0) from += 2 * PI;
+    double to = from + s.second;
+    intervals.emplace_back(from, min(to, 2 * PI));
+    if (to > 2 * PI) intervals.emplace_back(0, to - 2 * PI);
+  }
+  sort(intervals.begin(), intervals.end());
+  double reached = 0;
+  for (auto& i : intervals) {
+    if (i.first > reached + angleEps) return false;
+    reached = max(reached, i.second);
+  }
+  return reached >= 2 * PI - angleEps;
+}
+
+void Algorithm::refreshAnchors(int pci, const Polygon::BB& region) {
+  auto& pol = fixed[pci].pol;
+  double tol = anchorTolerance(problem.plate);
+  auto& bb = pol.get_bb();
+  if (bb.right < region.left - tol or bb.left > region.right + tol or
+      bb.top < region.bottom - tol or bb.bottom > region.top + tol)
+    return;
 
-  const std::vector<double>* angles =
-      (problem.phi == 0 ? &pc.angles : &problem.anglesVector);
-
-  for (const auto& angle : *angles) {
-    auto polRotated = pol.rotated(angle);
-    for (int vi = 0; vi < (int)polRotated.v.size(); ++vi) {
-      const auto& v = polRotated.v[vi];
-      for (int pci = 0; pci < (int)fixed.size(); ++pci) {
-        const auto& pc = fixed[pci];
-        for (int ui = 0; ui < (int)pc.pol.v.size(); ++ui) {
-          const auto& u = pc.pol.v[ui];
-          if (problem.timeLimitExceeded()) {
-            goto leave;
+  const auto& old = anchors[pci];
+  vector<int> active;
+  auto it = old.begin();
+  for (int ui = 0; ui < (int)pol.v.size(); ++ui) {
+    bool wasActive = (it != old.end() and *it == ui);
+    if (wasActive) ++it;
+    const auto& u = pol.v[ui];
+    if (pointInRectangle(u, region.left - tol, region.right + tol,
+                         region.top + tol, region.bottom - tol)) {
+      if (not anchorIsDead(u)) active.push_back(ui);
+    } else if (wasActive) {
+      active.push_back(ui);
+    }
+  }
+  if (active != old) {
+    journal.emplace_back(LayoutChange::Anchors, pci);
+    journal.back().anchors = move(anchors[pci]);
+    anchors[pci] = move(active);
+  }
+}
+
+void Algorithm::placePiece(const PiecePlacement& placement) {
+  if (repairLog) repairLog->placed.push_back(placement);
+  int n = fixed.size();
+  fixed.push_back(Piece(placement.pol));
+  fixed[n].id = placement.pieceId;
+  fixed[n].orientation = placement.angle;
+  g.emplace_back(1, placement.attached);
+  anchors.emplace_back();
+  journal.emplace_back(LayoutChange::Placed, n);
+  g[placement.attached].push_back(n);
+  journal.emplace_back(LayoutChange::EdgeAdded, placement.attached);
+
+  /* the new piece can only bury anchors inside its bounding box */
+  const auto region = fixed[n].pol.get_bb();
+  for (int i = 0; i <= n; ++i) {
+    refreshAnchors(i, region);
+  }
+
+  if (problem.optimizeCompaction) {
+    fixedArea += placement.pol.area();
+    for (auto& p : placement.pol.v)
+      chFixed.v.push_back(p);
+    chFixed = convexHull(chFixed.v);
+  }
+}
+
+void Algorithm::removePiece(int i) {
+  assert(i > 0 and i < (int)fixed.size());
+  int last = fixed.size() - 1;
+
+  /* detach i from its neighbours, and point the neighbours of last to i */
+  for (int a : g[i]) {
+    auto& v = g[a];
+    int pos = find(v.begin(), v.end(), i) - v.begin();
+    journal.emplace_back(LayoutChange::EdgeErased, a, pos, i);
+    v.erase(v.begin() + pos);
+  }
+  if (i != last) {
+    for (int a : g[last]) {
+      auto& v = g[a];
+      int pos = find(v.begin(), v.end(), last) - v.begin();
+      journal.emplace_back(LayoutChange::EdgeRenamed, a, pos, last);
+      v[pos] = i;
+    }
+  }
+
+  journal.emplace_back(LayoutChange::Removed, i);
+  auto& c = journal.back();
+  c.piece = move(fixed[i]);
+  c.adjacency = move(g[i]);
+  c.anchors = move(anchors[i]);
+  if (i != last) {
+    fixed[i] = move(fixed[last]);
+    g[i] = move(g[last]);
+    anchors[i] = move(anchors[last]);
+  }
+  fixed.pop_back();
+  g.pop_back();
+  anchors.pop_back();
+}
+
+void Algorithm::commitLayout() {
+  journal.clear();
+  committedFixedArea = fixedArea;
+  committedChFixed = chFixed;
+}
+
+void Algorithm::rollbackLayout() {
+  while (not journal.empty()) {
+    auto& c = journal.back();
+    switch (c.kind) {
+    case LayoutChange::Placed:
+      fixed.pop_back();
+      g.pop_back();
+      anchors.pop_back();
+      break;
+    case LayoutChange::Removed:
+      if (c.index < (int)fixed.size()) {
+        fixed.push_back(move(fixed[c.index]));
+        g.push_back(move(g[c.index]));
+        anchors.push_back(move(anchors[c.index]));
+        fixed[c.index] = move(c.piece);
+        g[c.index] = move(c.adjacency);
+        anchors[c.index] = move(c.anchors);
+      } else {
+        fixed.push_back(move(c.piece));
+        g.push_back(move(c.adjacency));
+        anchors.push_back(move(c.anchors));
+      }
+      break;
+    case LayoutChange::EdgeAdded:
+      g[c.index].pop_back();
+      break;
+    case LayoutChange::EdgeErased:
+      g[c.index].insert(g[c.index].begin() + c.pos, c.value);
+      break;
+    case LayoutChange::EdgeRenamed:
+      g[c.index][c.pos] = c.value;
+      break;
+    case LayoutChange::Anchors:
+      anchors[c.index] = move(c.anchors);
+      break;
+    }
+    journal.pop_back();
+  }
+  fixedArea = committedFixedArea;
+  chFixed = committedChFixed;
+}
+
+bool Algorithm::PositionSet::insert(const TriedPosition& p) {
+  if (2 * (count + 1) > (int)slots.size()) {
+    /* rehash the current generation into twice the slots */
+    vector<TriedPosition> old;
+    for (int i = 0; i < (int)slots.size(); ++i)
+      if (stamps[i] == generation) old.push_back(slots[i]);
+    int n = max<int>(1024, 2 * slots.size());
+    slots.assign(n, TriedPosition());
+    stamps.assign(n, 0);
+    generation = 1;
+    count = 0;
+    for (auto& q : old)
+      insert(q);
+  }
+  const size_t mask = slots.size() - 1;
+  for (size_t i = TriedPositionHash()(p) & mask;; i = (i + 1) & mask) {
+    if (stamps[i] != generation) {
+      stamps[i] = generation;
+      slots[i] = p;
+      ++count;
+      return true;
+    }
+    if (slots[i] == p) return false;
+  }
+}
+
+template <typename Policy>
+double Algorithm::tryOrientation(int floatIndex, int ai,
+                                 PiecePlacement& bestPlacement,
+                                 CandidateList* candidates) {
+  const int type = floating[floatIndex].id;
+  const auto& o = problem.pieceOrientations[type][ai];
+  const auto& polRotated = o.pol;
+  double best = DBL_MAX;
+  for (int vi = 0; vi < (int)polRotated.v.size(); ++vi) {
+    const auto& v = polRotated.v[vi];
+    for (int pci = 0; pci < (int)fixed.size(); ++pci) {
+      const auto& pc = fixed[pci];
+      for (int ui : anchors[pci]) {
+        const auto& u = pc.pol.v[ui];
+        if (stopRequested()) return best;
+        /* skip translations outside the inner-fit rectangle before
+         * building the translated polygon */
+        if (not o.fits(u - v)) continue;
+        TriedPosition position{ai, (int64_t)llround((u.x - v.x) / EPS),
+                               (int64_t)llround((u.y - v.y) / EPS)};
+        if (not triedPositions.insert(position)) {
+          ++statistics.numDuplicatePositions;
+          continue;
+        }
+        auto polTranslated = polRotated.translated(u - v);
+        if (isFeasibleKernel<Policy>(polTranslated, type, ai)) {
+          double value = objectiveKernel<Policy>(polTranslated);
+          if (candidates != nullptr) {
+            candidates->add({floatIndex, ai, vi, pci, ui, value});
           }
-          auto polTranslated = polRotated.translated(u - v);
-          if (isFeasible(polTranslated)) {
-            double value = objective(polTranslated);
-            auto candidate = PiecePlacement(move(polTranslated), floatIndex,
-                                            value, vi, pci, ui);
-            if (value < bestPlacement.value) {
-              bestPlacement = candidate;
-            }
-            if (candidates != nullptr) {
-              candidates->push_back(move(candidate));
-            }
+          best = min(best, value);
+          if (value < bestPlacement.value) {
+            bestPlacement = PiecePlacement(move(polTranslated), floatIndex,
+                                           value, vi, pci, ui);
+            bestPlacement.angle = ai;
           }
         }
       }
     }
   }
-leave:;
+  return best;
+}
+
+template <typename Policy>
+Algorithm::PiecePlacement
+Algorithm::selectPiecePlacementKernel(int floatIndex,
+                                      CandidateList* candidates) {
+  TRACE_SCOPE("selectPiecePlacement");
+  const int type = floating[floatIndex].id;
+  PiecePlacement bestPlacement;
+  bestPlacement.value = DBL_MAX;
+  triedPositions.clear();
+
+  const int n = problem.pieceOrientations[type].size();
+  const int stride = problem.coarseStride;
+  if (stride <= 1) {
+    for (int ai = 0; ai < n and not stopRequested(); ++ai)
+      tryOrientation<Policy>(floatIndex, ai, bestPlacement, candidates);
+  } else {
+    /* coarse-to-fine: every stride-th orientation, then around the best
+     * ones so far at half the previous step, down to neighbours */
+    orientationValue.assign(n, DBL_MAX);
+    orientationTried.assign(n, false);
+    auto tryAt = [&](int ai) {
+      if (problem.anglePeriod > 0)
+        ai = (ai % problem.anglePeriod + problem.anglePeriod) %
+             problem.anglePeriod;
+      if (ai < 0 or ai >= n or orientationTried[ai] or stopRequested())
+        return;
+      orientationTried[ai] = true;
+      orientationValue[ai] =
+          tryOrientation<Policy>(floatIndex, ai, bestPlacement, candidates);
+    };
+    for (int ai = 0; ai < n; ai += stride)
+      tryAt(ai);
+    for (int step = stride; step > 1;) {
+      step = (step + 1) / 2;
+      bestOrientations.clear();
+      for (int ai = 0; ai < n; ++ai)
+        if (orientationValue[ai] < DBL_MAX) bestOrientations.push_back(ai);
+      int k = min<int>(problem.refineAngles, bestOrientations.size());
+      partial_sort(bestOrientations.begin(), bestOrientations.begin() + k,
+                   bestOrientations.end(), [&](int a, int b) {
+                     return orientationValue[a] < orientationValue[b] or
+                            (orientationValue[a] == orientationValue[b] and
+                             a < b);
+                   });
+      bestOrientations.resize(k);
+      for (int ai : bestOrientations) {
+        tryAt(ai - step);
+        tryAt(ai + step);
+      }
+    }
+  }
+  if (bestPlacement.floatIndex != -1) bestPlacement.pieceId = type;
   return bestPlacement;
 }
 
+Algorithm::PiecePlacement Algorithm::materialize(const Candidate& c) const {
+  const auto& o =
+      problem.pieceOrientations[floating[c.floatIndex].id][c.angle].pol;
+  const auto& u = fixed[c.attached].pol.v[c.attachedVertex];
+  PiecePlacement placement(o.translated(u - o.v[c.vertex]), c.floatIndex,
+                           c.value, c.vertex, c.attached, c.attachedVertex);
+  placement.pieceId = floating[c.floatIndex].id;
+  placement.angle = c.angle;
+  return placement;
+}
+
 void Algorithm::constructiveGreedy() {
-  floating = problem.pieces;
+  MEMORY_PHASE(Constructive);
+  floating.reset();
   pieceQuantity = problem.pieceQuantity;
-  if (g.empty()) g.emplace_back();
-
-  /* Sort floating pieces according to area */
-  sort(begin(floating), end(floating), [&](const Piece& a, const Piece& b) {
-    return a.pol.area() > b.pol.area();
-  });
+  if (not problem.infinitePolygons) {
+    /* only the copies not in the layout yet are available */
+    for (int i = 1; i < (int)fixed.size(); ++i) {
+      if (fixed[i].id >= 0) --pieceQuantity[fixed[i].id];
+    }
+    for (int pos = floating.first(); pos != floating.end();
+         pos = floating.after(pos)) {
+      if (pieceQuantity[floating[pos].id] <= 0) floating.remove(pos);
+    }
+  }
 
-  vector<PiecePlacement> alphaCandidates;
+  /* kept across steps, so that their buffers are reused */
+  CandidateList alphaCandidates;
+  vector<int> window, unplaceable;
 
   while (floating.size()) {
-    if (problem.timeLimitExceeded()) break;
-    int lm = std::min(problem.m, (int)floating.size());
+    if (stopRequested()) break;
+    TRACE_SCOPE("constructive step");
+    /* the lm largest pieces are tried */
+    int lm = std::min(problem.m, floating.size());
+    window.clear();
+    for (int pos = floating.first(); (int)window.size() < lm;
+         pos = floating.after(pos))
+      window.push_back(pos);
     PiecePlacement bestPlacement;
-    vector<int> indicesToRemove;
+    unplaceable.clear();
 
     if (problem.alphaGreedy) {
       alphaCandidates.clear();
-      for (int i = 0; i < lm; ++i) {
-        selectPiecePlacement(i, &alphaCandidates);
+      for (int pos : window) {
+        selectPiecePlacement(pos, &alphaCandidates);
       }
-      // 			cout << "number of candidates: " << alphaCandidates.size() <<
-      // endl;
 
-      double bestVal = -1, worstVal = DBL_MAX;
-      for (auto& c : alphaCandidates) {
-        bestVal = max(bestVal, c.value);
-        worstVal = min(worstVal, c.value);
-      }
+      /* the extreme values were tracked while the candidates were added */
+      double bestVal = alphaCandidates.maxValue;
+      double worstVal = alphaCandidates.minValue;
 
       int candidateNumber = 0;
-      for (auto& c : alphaCandidates) {
+      const Candidate* chosen = nullptr;
+      for (auto& c : alphaCandidates.records) {
         if (c.value >= bestVal - problem.alpha * (bestVal - worstVal)) {
           ++candidateNumber;
           if (rng.reservoirSampling(candidateNumber)) {
-            bestPlacement = move(c);
+            chosen = &c;
           }
         }
       }
+      if (chosen != nullptr) bestPlacement = materialize(*chosen);
     } else {
-      for (int i = 0; i < lm; ++i) {
-        assert((int)floating.size() >= i + 1);
-        auto placement = selectPiecePlacement(i, nullptr);
+      for (int pos : window) {
+        auto placement = selectPiecePlacement(pos, nullptr);
         if (placement.value == DBL_MAX) {
-          indicesToRemove.push_back(i);
+          unplaceable.push_back(pos);
         }
         if (placement.value < bestPlacement.value) {
           bestPlacement = move(placement);
@@ -226,35 +692,22 @@ void Algorithm::constructiveGreedy() {
     if (bestPlacement.floatIndex == -1) {
       /* no possible placements for any of the the first lm pieces;
        * remove them */
-      floating.erase(floating.begin(), floating.begin() + lm);
+      for (int pos : window)
+        floating.remove(pos);
       continue;
     }
 
-    assert(find(indicesToRemove.begin(), indicesToRemove.end(),
-                bestPlacement.floatIndex) == indicesToRemove.end());
-
-    --pieceQuantity[floating[bestPlacement.floatIndex].id];
-    if (pieceQuantity[floating[bestPlacement.floatIndex].id] == 0) {
-      floating.erase(floating.begin() + bestPlacement.floatIndex);
-      for (auto& i : indicesToRemove) {
-        if (i > bestPlacement.floatIndex) --i;
-      }
-    }
-
-    for (int i = indicesToRemove.size() - 1; i >= 0; --i) {
-      floating.erase(floating.begin() + indicesToRemove[i]);
+    if (--pieceQuantity[bestPlacement.pieceId] == 0) {
+      floating.remove(bestPlacement.floatIndex);
     }
+    for (int pos : unplaceable)
+      floating.remove(pos);
 
-    fixed.push_back(Piece(bestPlacement.pol));
-    g.emplace_back();
-    g[fixed.size() - 1].push_back(bestPlacement.attached);
-    g[bestPlacement.attached].push_back(fixed.size() - 1);
-
-    if (problem.optimizeCompaction) {
-      fixedArea += bestPlacement.pol.area();
-      for (auto& p : bestPlacement.pol.v)
-        chFixed.v.push_back(p);
-      chFixed = convexHull(chFixed.v);
+    placePiece(bestPlacement);
+    if (tracer.enabled) {
+      tracer.counter("utilization", 100.0 * fixedArea / problem.plate.area());
+      tracer.counter("floating pieces", floating.size());
+      tracer.counter("candidates evaluated", statistics.numFeasabilityTests);
     }
     println(fixed.size(), " polygons fixed, ", floating.size(),
             " polygons left, ", 100.0 * fixedArea / problem.plate.area(),
@@ -263,22 +716,28 @@ void Algorithm::constructiveGreedy() {
 }
 
 void Algorithm::alphaGreedy() {
-  vector<Piece> bestFixed;
+  MEMORY_PHASE(Search);
   double bestFixedArea = 0.0;
   statistics.iterations = 0;
   double bestMaxX = DBL_MAX;
-  while (not problem.timeLimitExceeded()) {
+  int64_t lastImprovement = 0;
+  double lastImprovementTime = timerSeconds(problem.timer);
+  commitLayout();
+  while (not stopRequested() and not finishReason) {
+    TRACE_SCOPE("alpha greedy iteration");
+    /* start from the empty plate; the incumbent goes to the journal */
+    for (int i = fixed.size() - 1; i > 0; --i)
+      removePiece(i);
+    refreshAnchors(0, problem.plate.get_bb());
     fixedArea = 0.0;
     chFixed = Polygon();
-    g.clear();
-    fixed.clear();
-    fixed.push_back(Piece(problem.plate));
     constructiveGreedy();
 
-    if (problem.optimizeCompaction) {
-      if (fixedArea > bestFixedArea) {
+    bool improved = false;
+    if (areaObjective()) {
+      if (fixedArea > bestFixedArea and layoutComplete()) {
         bestFixedArea = fixedArea;
-        bestFixed = fixed;
+        improved = true;
       }
     } else {
       double maxX = -100000;
@@ -287,42 +746,71 @@ void Algorithm::alphaGreedy() {
         for (auto& p : pc.pol.v)
           maxX = max(maxX, p.x);
       }
-      if (maxX < bestMaxX) {
+      if (maxX < bestMaxX and layoutComplete()) {
         bestMaxX = maxX;
         bestFixedArea = fixedArea;
-        bestFixed = fixed;
+        improved = true;
       }
-      cout << "maxX: " << maxX << ", bestMaxX: " << bestFixedArea << endl;
+      LOG(LogDebug, "maxX: ", maxX, ", bestMaxX: ", bestFixedArea);
     }
 
     if (statistics.iterations == 0) {
       statistics.v0 = 100 * bestFixedArea / problem.plate.area();
     }
 
-    cout << "alpha greedy #" << ++statistics.iterations
-         << ": current value: " << 100 * fixedArea / problem.plate.area()
-         << " %"
-         << ", best value: " << 100 * bestFixedArea / problem.plate.area()
-         << " %" << endl;
+    println("alpha greedy #", ++statistics.iterations, ": current value: ",
+            100 * fixedArea / problem.plate.area(), " %, best value: ",
+            100 * bestFixedArea / problem.plate.area(), " %");
+    if (improved) {
+      commitLayout();
+      lastImprovement = statistics.iterations;
+      lastImprovementTime = timerSeconds(problem.timer);
+      if (onImprovement) onImprovement(*this);
+    } else {
+      rollbackLayout();
+    }
+    tracer.counter("best value", 100 * bestFixedArea / problem.plate.area());
+    checkEarlyStop(bestFixedArea, lastImprovement, lastImprovementTime);
   }
-  fixed = bestFixed;
+  rollbackLayout();
   fixedArea = bestFixedArea;
 }
 
 void Algorithm::iteratedGreedy() {
-  vector<Piece> bestFixed;
+  MEMORY_PHASE(Search);
+  if (problem.numThreads > 1) {
+    parallelIteratedGreedy();
+    return;
+  }
   double bestFixedArea = 0.0;
   double bestMaxX = DBL_MAX;
-  vector<vector<int>> bestG;
+  double nextMigration = problem.migrationSeconds;
+  double nextCheckpoint = problem.checkpointSeconds;
   statistics.iterations = 0;
-  while (not problem.timeLimitExceeded()) {
+  commitLayout();
+  int64_t lastImprovement = 0;
+  double lastImprovementTime = timerSeconds(problem.timer);
+  if (not problem.resumeFile.empty()) {
+    readCheckpoint(problem.resumeFile, bestFixedArea, bestMaxX);
+    println("resuming iteration ", statistics.iterations, " of ",
+            problem.resumeFile, " at ", timerSeconds(problem.timer),
+            " seconds");
+    nextMigration = timerSeconds(problem.timer) + problem.migrationSeconds;
+    nextCheckpoint = timerSeconds(problem.timer) + problem.checkpointSeconds;
+    lastImprovement = statistics.iterations;
+    lastImprovementTime = timerSeconds(problem.timer);
+    /* the checkpoint was taken just before deconstructing */
+    deconstruct();
+  }
+  while (not stopRequested() and not finishReason) {
+    TRACE_SCOPE("iterated greedy iteration");
     constructiveGreedy();
 
-    if (problem.optimizeCompaction) {
-      if (fixedArea > bestFixedArea) {
+    bool improved = false;
+    if (areaObjective()) {
+      if (fixedArea > bestFixedArea and layoutComplete()) {
         bestFixedArea = fixedArea;
-        bestFixed = fixed;
-        bestG = g;
+        improved = true;
       }
     } else {
       double maxX = -100000;
@@ -331,45 +819,309 @@ void Algorithm::iteratedGreedy() {
         for (auto& p : pc.pol.v)
           maxX = max(maxX, p.x);
       }
-      if (maxX < bestMaxX) {
+      if (maxX < bestMaxX and layoutComplete()) {
         bestMaxX = maxX;
         bestFixedArea = fixedArea;
-        bestFixed = fixed;
-        bestG = g;
+        improved = true;
       }
-      cout << "maxX: " << maxX << ", bestMaxX: " << bestFixedArea << endl;
+      LOG(LogDebug, "maxX: ", maxX, ", bestMaxX: ", bestFixedArea);
     }
 
     if (statistics.iterations == 0) {
       statistics.v0 = 100 * bestFixedArea / problem.plate.area();
     }
 
-    cout << "iterated greedy #" << ++statistics.iterations
-         << ": current value: " << 100 * fixedArea / problem.plate.area()
-         << " %"
-         << ", best value: " << 100 * bestFixedArea / problem.plate.area()
-         << " %" << endl;
+    println("iterated greedy #", ++statistics.iterations, ": current value: ",
+            100 * fixedArea / problem.plate.area(), " %, best value: ",
+            100 * bestFixedArea / problem.plate.area(), " %");
+    if (improved) {
+      commitLayout();
+      lastImprovement = statistics.iterations;
+      lastImprovementTime = timerSeconds(problem.timer);
+      if (onImprovement) onImprovement(*this);
+    } else {
+      rollbackLayout();
+    }
+    tracer.counter("best value", 100 * bestFixedArea / problem.plate.area());
     fixedArea = bestFixedArea;
-    fixed = bestFixed;
-    g = bestG;
-    if (problem.timeLimitExceeded()) break;
+
+    if (islands.enabled() and timerSeconds(problem.timer) >= nextMigration) {
+      nextMigration += problem.migrationSeconds;
+      vector<Polygon> elite;
+      double eliteScore;
+      if (islands.migrate(problem.optimizeCompaction ? bestFixedArea
+                                                     : -bestMaxX,
+                          layoutPolygons(), elite, eliteScore) and
+          adoptIfBetter(elite)) {
+        println("adopting layout from another island, value ",
+                100 * fixedArea / problem.plate.area(), " %");
+        bestFixedArea = fixedArea;
+        bestMaxX = layoutMaxX();
+        lastImprovement = statistics.iterations;
+        lastImprovementTime = timerSeconds(problem.timer);
+        if (onImprovement) onImprovement(*this);
+      }
+    }
+
+    if (not problem.checkpointFile.empty() and
+        timerSeconds(problem.timer) >= nextCheckpoint) {
+      nextCheckpoint += problem.checkpointSeconds;
+      writeCheckpoint(problem.checkpointFile, bestFixedArea, bestMaxX);
+    }
+
+    checkEarlyStop(bestFixedArea, lastImprovement, lastImprovementTime);
+    if (stopRequested() or finishReason) break;
     deconstruct();
 
     // 		problem.outputFile = "deconstruction.txt"; writeOutput();
 
     // 		cout << "area after deconstructing: " << fixedArea << endl;
   }
-  fixed = bestFixed;
+  rollbackLayout();
+
+  vector<Polygon> elite;
+  double eliteScore;
+  if (islands.finish(problem.optimizeCompaction ? bestFixedArea : -bestMaxX,
+                     layoutPolygons(), elite, eliteScore) and
+      adoptIfBetter(elite)) {
+    println("final layout from another island, value ",
+            100 * fixedArea / problem.plate.area(), " %");
+    bestFixedArea = fixedArea;
+    if (onImprovement) onImprovement(*this);
+  }
   fixedArea = bestFixedArea;
 }
 
+void Algorithm::parallelIteratedGreedy() {
+  MEMORY_PHASE(Search);
+  if (not problem.checkpointFile.empty() or not problem.resumeFile.empty())
+    println("checkpoints are only supported with one thread");
+
+  /* the first layout is built as in the sequential search */
+  constructiveGreedy();
+  commitLayout();
+  statistics.iterations = 1;
+  statistics.v0 = 100 * fixedArea / problem.plate.area();
+  shared_ptr<const Incumbent> incumbent = snapshot(0);
+  if (onImprovement) onImprovement(*this);
+
+  int n = problem.numThreads;
+  vector<Statistics> workerStatistics(n);
+  vector<unique_ptr<Algorithm>> workers;
+  vector<thread> threads;
+  /* the work budget left is split among the workers */
+  int64_t workLeft = max<int64_t>(n, workBudget - statistics.work());
+  atomic<int> running(n);
+  for (int i = 0; i < n; ++i) {
+    workers.emplace_back(new Algorithm(problem, workerStatistics[i]));
+    Algorithm* w = workers.back().get();
+    w->rng = rng.stream(i + 1);
+    if (workBudget > 0) w->workBudget = workLeft / n + (i < workLeft % n);
+    w->bindKernels();
+    w->floating.assign(problem.pieces);
+    threads.emplace_back([w, i, &incumbent, &running] {
+      setLogTag("worker " + toString(i + 1));
+      w->speculativeRepair(&incumbent);
+      --running;
+    });
+  }
+
+  /* follow the incumbent, for the output and the island model */
+  uint64_t seen = 0;
+  double nextMigration = problem.migrationSeconds;
+  double lastImprovementTime = timerSeconds(problem.timer);
+  while (not stopRequested() and not finishReason and running > 0) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+    auto current = atomic_load(&incumbent);
+    if (current->version != seen) {
+      seen = current->version;
+      restore(*current);
+      println("parallel iterated greedy: improvement #", seen,
+              ", best value: ", 100 * fixedArea / problem.plate.area(), " %");
+      tracer.counter("best value", 100 * fixedArea / problem.plate.area());
+      lastImprovementTime = timerSeconds(problem.timer);
+      if (onImprovement) onImprovement(*this);
+    }
+    /* the workers count the iterations, so only time stagnates here */
+    checkEarlyStop(current->fixedArea, statistics.iterations,
+                   lastImprovementTime);
+
+    if (islands.enabled() and timerSeconds(problem.timer) >= nextMigration) {
+      nextMigration += problem.migrationSeconds;
+      restore(*current);
+      vector<Polygon> elite;
+      double eliteScore;
+      if (islands.migrate(current->score, layoutPolygons(), elite,
+                          eliteScore) and
+          adoptIfBetter(elite)) {
+        /* if a worker improved meanwhile, its layout is kept instead */
+        shared_ptr<const Incumbent> adopted = snapshot(current->version + 1);
+        atomic_compare_exchange_strong(&incumbent, &current, adopted);
+      }
+    }
+  }
+  for (auto& w : workers)
+    w->cancelled = true;
+  for (auto& t : threads)
+    t.join();
+
+  for (auto& ws : workerStatistics)
+    statistics.add(ws);
+  restore(*incumbent);
+
+  vector<Polygon> elite;
+  double eliteScore;
+  if (islands.finish(incumbent->score, layoutPolygons(), elite, eliteScore) and
+      adoptIfBetter(elite)) {
+    println("final layout from another island, value ",
+            100 * fixedArea / problem.plate.area(), " %");
+    if (onImprovement) onImprovement(*this);
+  }
+}
+
+void Algorithm::speculativeRepair(shared_ptr<const Incumbent>* incumbent) {
+  MEMORY_PHASE(Search);
+  silentOutput() = true;
+  auto base = atomic_load(incumbent);
+  restore(*base);
+  Repair attempt;
+  repairLog = &attempt;
+  while (not stopRequested()) {
+    TRACE_SCOPE("speculative iteration");
+    attempt.removed.clear();
+    attempt.placed.clear();
+    deconstruct();
+    constructiveGreedy();
+    ++statistics.iterations;
+
+    auto previous = base;
+    if (layoutComplete() and layoutScore() > base->score) {
+      auto next = snapshot(base->version + 1);
+      next->previous = base;
+      next->repair = attempt;
+      shared_ptr<const Incumbent> published = next;
+      if (atomic_compare_exchange_strong(incumbent, &base, published)) {
+        commitLayout();
+        base = published;
+        continue;
+      }
+      /* another worker won; base is now its layout */
+    } else {
+      base = atomic_load(incumbent);
+    }
+    rollbackLayout();
+    if (base != previous) rebase(*previous, base);
+  }
+  repairLog = nullptr;
+}
+
+void Algorithm::rebase(const Incumbent& from,
+                       const shared_ptr<const Incumbent>& to) {
+  /* placements are not recorded while replaying */
+  Repair* log = repairLog;
+  repairLog = nullptr;
+  vector<shared_ptr<const Incumbent>> chain;
+  auto p = to;
+  while (p and p->version > from.version) {
+    chain.push_back(p);
+    p = p->previous.lock();
+  }
+  if (p.get() == &from) {
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      removePieces((*it)->repair.removed);
+      for (auto& placement : (*it)->repair.placed)
+        placePiece(placement);
+    }
+    commitLayout();
+  } else {
+    restore(*to);
+  }
+  repairLog = log;
+}
+
+shared_ptr<Algorithm::Incumbent>
+Algorithm::snapshot(uint64_t version) const {
+  auto s = make_shared<Incumbent>();
+  s->version = version;
+  s->score = layoutScore();
+  s->fixedArea = fixedArea;
+  s->chFixed = chFixed;
+  s->fixed = fixed;
+  s->g = g;
+  s->anchors = anchors;
+  return s;
+}
+
+void Algorithm::restore(const Incumbent& incumbent) {
+  fixedArea = incumbent.fixedArea;
+  chFixed = incumbent.chFixed;
+  fixed = incumbent.fixed;
+  g = incumbent.g;
+  anchors = incumbent.anchors;
+  commitLayout();
+}
+
+bool Algorithm::layoutComplete() const {
+  if (not problem.keepAllPieces) return true;
+  for (int q : pieceQuantity) {
+    if (q > 0) return false;
+  }
+  return true;
+}
+
+bool Algorithm::areaObjective() const {
+  return problem.optimizeCompaction and not problem.keepAllPieces;
+}
+
+double Algorithm::areaBound() const {
+  double area = 0;
+  for (auto& pc : problem.pieces)
+    area += problem.pieceQuantity[pc.id] * pc.pol.area();
+  return min(area, problem.plate.area());
+}
+
+void Algorithm::checkEarlyStop(double bestFixedArea, int64_t lastImprovement,
+                               double lastImprovementTime) {
+  double utilization = 100 * bestFixedArea / problem.plate.area();
+  /* placed areas are only tracked when they are the objective */
+  if (areaObjective() and bestFixedArea >= areaBound() * (1 - 1e-9)) {
+    finishReason = "area-bound";
+  } else if (problem.targetUtilization > 0 and
+             utilization >= problem.targetUtilization) {
+    finishReason = "target";
+  } else if (problem.stagnationIterations > 0 and
+             statistics.iterations - lastImprovement >=
+                 problem.stagnationIterations) {
+    finishReason = "stagnation";
+  } else if (problem.stagnationSeconds > 0 and
+             timerSeconds(problem.timer) - lastImprovementTime >=
+                 problem.stagnationSeconds) {
+    finishReason = "stagnation";
+  }
+  if (finishReason)
+    println("stopping early (", finishReason, ") at ", utilization,
+            " % utilization");
+}
+
+const char* Algorithm::stopReason() const {
+  if (finishReason) return finishReason;
+  if (cancelled) return "cancelled";
+  if (workBudget > 0 and statistics.work() >= workBudget) return "work-budget";
+  if (problem.timeLimitExceeded()) return "time";
+  return "completed";
+}
+
+double Algorithm::layoutScore() const {
+  return areaObjective() ? fixedArea : -layoutMaxX();
+}
+
 void Algorithm::randomPlacementAlgorithm() {
-  floating = problem.pieces;
-  while (floating.size() and not problem.timeLimitExceeded()) {
-    int pci = rng.randomInt(0, floating.size() - 1);
+  vector<Piece> pieces = problem.pieces;
+  while (pieces.size() and not stopRequested()) {
+    int pci = rng.randomInt(0, pieces.size() - 1);
     int ang = rng.randomInt(0, problem.anglesVector.size() - 1);
 
-    auto polR = floating[pci].pol.rotated(ang);
+    auto polR = pieces[pci].pol.rotated(ang);
     // 		polR = polR.translated(-polR.centroid());
     for (auto& v : polR.v) {
       for (auto& pc : fixed) {
@@ -386,14 +1138,17 @@ void Algorithm::randomPlacementAlgorithm() {
         }
       }
     }
-    floating.erase(floating.begin() + pci);
+    pieces.erase(pieces.begin() + pci);
   exitForLoop:;
   }
 }
 
 void Algorithm::deconstruct() {
+  MEMORY_PHASE(Deconstruct);
+  TRACE_SCOPE("deconstruct");
   double areaToDeconstruct =
       problem.areaPercentToDeconstruct * problem.plate.area();
+  if (fixed.size() <= 1) return;
 
   /* choose a randomly fixed vertex */
   int v = rng.randomInt(1, fixed.size() - 1);
@@ -401,11 +1156,12 @@ void Algorithm::deconstruct() {
   vector<bool> visited(fixed.size(), false);
   vector<bool> removed(fixed.size(), false);
   double area = 0.0;
+  int numToRemove = fixed.size() - 1;
 
   visited[v] = true;
   q.push(v);
-  while (area < areaToDeconstruct) {
-    if (problem.timeLimitExceeded()) return;
+  while (area < areaToDeconstruct and numToRemove > 0) {
+    if (stopRequested()) return;
     int p;
     if (q.empty()) {
       // 			cout << "selecting random p" << endl;
@@ -425,6 +1181,7 @@ void Algorithm::deconstruct() {
     assert(visited[p]);
     assert(not removed[p]);
     removed[p] = true;
+    --numToRemove;
     area += fixed[p].pol.area();
     for (int i = 0; i < (int)g[p].size(); ++i) {
       int v = g[p][i];
@@ -436,33 +1193,31 @@ void Algorithm::deconstruct() {
   }
 
   assert(removed[0] == false);
-  vector<int> index(fixed.size());
-  int numRemoved = 0;
-  for (int i = 0; i < (int)fixed.size(); ++i)
-    index[i] = i;
-  for (int r = 0; r < (int)removed.size(); ++r) {
-    if (removed[r]) {
-      ++numRemoved;
-      index[r] = -1;
-      for (int j = r + 1; j < (int)fixed.size(); ++j)
-        --index[j];
-    }
-  }
-  // 	cout << "removed " << numRemoved << " polygons" << endl;
-  assert(index[0] == 0);
-
-  for (int i = fixed.size() - 1; i >= 0; --i) {
-    if (index[i] < 0) {
-      fixed.erase(fixed.begin() + i);
-      g.erase(g.begin() + i);
-    } else {
-      auto& v = g[i];
-      v.erase(
-          remove_if(v.begin(), v.end(), [&](int a) { return index[a] < 0; }),
-          v.end());
-    }
+
+  /* removing from the back never moves a piece that is yet to be removed */
+  vector<int> indices;
+  for (int i = fixed.size() - 1; i > 0; --i) {
+    if (removed[i]) indices.push_back(i);
+  }
+  removePieces(indices);
+}
+
+void Algorithm::removePieces(const vector<int>& indices) {
+  if (repairLog) repairLog->removed = indices;
+  vector<Polygon::BB> freed;
+  for (int i : indices) {
+    freed.push_back(fixed[i].pol.get_bb());
+    removePiece(i);
   }
   assert(g.size() == fixed.size());
+  assert(anchors.size() == fixed.size());
+
+  /* anchors buried by the removed pieces may be free again */
+  for (auto& region : freed) {
+    for (int i = 0; i < (int)fixed.size(); ++i) {
+      refreshAnchors(i, region);
+    }
+  }
   fixedArea = 0;
   vector<Point> pts;
   for (int i = 1; i < (int)fixed.size(); ++i) {
@@ -471,12 +1226,146 @@ void Algorithm::deconstruct() {
     for (auto& p : pc.pol.v)
       pts.push_back(p);
   }
-  chFixed = convexHull(pts);
+  chFixed = pts.empty() ? Polygon() : convexHull(pts);
 }
 
-void Algorithm::run() {
+void Algorithm::clearLayout() {
+  fixedArea = 0.0;
+  chFixed = Polygon();
   fixed.clear();
   fixed.push_back(Piece(problem.plate));
+  g.clear();
+  g.emplace_back();
+  anchors.assign(1, vector<int>(problem.plate.v.size()));
+  for (int i = 0; i < (int)problem.plate.v.size(); ++i)
+    anchors[0][i] = i;
+  commitLayout();
+}
+
+vector<Polygon> Algorithm::layoutPolygons() const {
+  vector<Polygon> layout;
+  for (int i = 1; i < (int)fixed.size(); ++i)
+    layout.push_back(fixed[i].pol);
+  return layout;
+}
+
+double Algorithm::layoutMaxX() const {
+  double maxX = -100000;
+  for (int i = 1; i < (int)fixed.size(); ++i) {
+    for (auto& p : fixed[i].pol.v)
+      maxX = max(maxX, p.x);
+  }
+  return maxX;
+}
+
+void Algorithm::adoptLayout(const vector<Polygon>& layout) {
+  clearLayout();
+  double tol = anchorTolerance(problem.plate);
+  vector<int> quantity = problem.pieceQuantity;
+  int dropped = 0;
+  for (auto& pol : layout) {
+    PiecePlacement placement;
+
+    /* find the piece and orientation that match pol best up to a
+     * translation: with a phi that divides 360, the orientations at 0 and
+     * 360 degrees differ only by rounding */
+    double bestError = 100 * tol * tol;
+    for (auto& pc : problem.pieces) {
+      if (quantity[pc.id] <= 0 and not problem.infinitePolygons) continue;
+      const auto& orientations = problem.pieceOrientations[pc.id];
+      for (int a = 0; a < (int)orientations.size(); ++a) {
+        const auto& o = orientations[a];
+        if (o.pol.v.size() != pol.v.size()) continue;
+        Point t = pol.v[0] - o.pol.v[0];
+        double error = 0;
+        for (int i = 0; i < (int)pol.v.size() and error < bestError; ++i) {
+          error = max(error, distSquared(o.pol.v[i] + t, pol.v[i]));
+        }
+        if (error < bestError) {
+          /* placed as the search places it, so that it is tested alike */
+          bestError = error;
+          placement.pieceId = pc.id;
+          placement.angle = a;
+          placement.pol = o.pol.translated(t);
+        }
+      }
+    }
+    if (placement.pieceId == -1 or
+        not isFeasible(placement.pol, placement.pieceId, placement.angle)) {
+      ++dropped;
+      continue;
+    }
+    --quantity[placement.pieceId];
+
+    /* attach it to a piece it touches at a vertex, or else to the plate */
+    placement.attached = 0;
+    for (int i = 1; i < (int)fixed.size() and placement.attached == 0; ++i) {
+      for (auto& u : fixed[i].pol.v) {
+        for (auto& p : placement.pol.v) {
+          if (distSquared(u, p) < tol * tol) placement.attached = i;
+        }
+      }
+    }
+    placePiece(placement);
+  }
+  if (dropped) println(dropped, " pieces of the layout were dropped");
+  commitLayout();
+}
+
+bool Algorithm::adoptIfBetter(const vector<Polygon>& layout) {
+  auto current = snapshot(0);
+  adoptLayout(layout);
+  if (layoutComplete() and layoutScore() > current->score) return true;
+  restore(*current);
+  return false;
+}
+
+vector<Polygon> Algorithm::readLayout(const string& file) const {
+  MEMORY_PHASE(IO);
+  ifstream f(file);
+  assert(not f.fail());
+  int numPlateVertices, numPieces;
+  double x, y;
+  f >> numPlateVertices;
+  for (int i = 0; i < numPlateVertices; ++i)
+    f >> x >> y;
+  f >> numPieces;
+  vector<Polygon> layout(numPieces);
+  for (auto& pol : layout) {
+    int numVertices;
+    f >> numVertices;
+    pol.v.resize(numVertices);
+    for (auto& p : pol.v)
+      f >> p.x >> p.y;
+  }
+  return layout;
+}
+
+void Algorithm::run() {
+  prepare();
+  search();
+}
+
+void Algorithm::seedRandom() {
+  /* islands sharing a seed still search differently */
+  rng.seed(problem.randomSeed);
+  rng = rng.stream(problem.islandId);
+}
+
+void Algorithm::prepare() {
+  seedRandom();
+  finishReason = nullptr;
+  bindKernels();
+  floating.assign(problem.pieces);
+  clearLayout();
+  if (not problem.initFile.empty()) {
+    adoptLayout(readLayout(problem.initFile));
+    println("starting from ", fixed.size() - 1, " pieces of ",
+            problem.initFile);
+  }
+}
+
+void Algorithm::search() {
   if (problem.randomAlgorithm) {
     println("running random algorithm");
     randomPlacementAlgorithm();
@@ -493,8 +1382,15 @@ void Algorithm::run() {
 }
 
 void Algorithm::writeOutput() {
+  MEMORY_PHASE(IO);
   ofstream f(problem.outputFile);
   assert(not f.fail());
+  writeLayout(f);
+}
+
+void Algorithm::writeLayout(ostream& f) const {
+  /* enough digits to read the layout back exactly (--init) */
+  f.precision(numeric_limits<double>::max_digits10);
   f << problem.plate.v.size() << endl;
   for (auto& p : problem.plate.v)
     f << p.x << " " << p.y << endl;
@@ -506,3 +1402,130 @@ void Algorithm::writeOutput() {
       f << p.x << " " << p.y << endl;
   }
 }
+
+void Algorithm::writeCheckpoint(const string& file, double bestFixedArea,
+                                double bestMaxX) const {
+  MEMORY_PHASE(IO);
+  string tmp = file + ".tmp";
+  {
+    ofstream f(tmp);
+    assert(not f.fail());
+    f.precision(numeric_limits<double>::max_digits10);
+    f << "cut-checkpoint 2" << endl;
+    f << timerSeconds(problem.timer) << " " << rng.key << " " << rng.counter
+      << endl;
+    f << bestFixedArea << " " << bestMaxX << " " << fixedArea << endl;
+    f << statistics.v0 << " " << statistics.iterations << " "
+      << statistics.numFeasabilityTests << " " << statistics.numBBTests << " "
+      << statistics.numBBTestsSucceeded << endl;
+    f << statistics.numPairTests << " " << statistics.numPairMemoHits << " "
+      << statistics.numDuplicatePositions << " "
+      << statistics.numApproxAccepts << " " << statistics.numApproxRejects
+      << endl;
+    f << pieceQuantity.size();
+    for (int q : pieceQuantity)
+      f << " " << q;
+    f << endl;
+
+    /* piece i: id, orientation, vertices, contact graph and anchors; piece
+     * 0 is the plate */
+    f << fixed.size() << endl;
+    for (int i = 0; i < (int)fixed.size(); ++i) {
+      f << fixed[i].id << " " << fixed[i].orientation << " "
+        << fixed[i].pol.v.size();
+      if (i > 0) {
+        for (auto& p : fixed[i].pol.v)
+          f << " " << p.x << " " << p.y;
+      }
+      f << endl << g[i].size();
+      for (int a : g[i])
+        f << " " << a;
+      f << endl << anchors[i].size();
+      for (int a : anchors[i])
+        f << " " << a;
+      f << endl;
+    }
+    assert(not f.fail());
+  }
+  if (rename(tmp.c_str(), file.c_str()) != 0) {
+    println("could not write checkpoint ", file);
+  }
+}
+
+void Algorithm::readCheckpoint(const string& file, double& bestFixedArea,
+                               double& bestMaxX) {
+  MEMORY_PHASE(IO);
+  ifstream f(file);
+  string header;
+  int version;
+  f >> header >> version;
+  if (f.fail() or header != "cut-checkpoint" or version != 2) {
+    LOG(LogError, "error: ", file, " is not a checkpoint of this version.");
+    exit(EXIT_FAILURE);
+  }
+
+  double elapsed;
+  f >> elapsed >> rng.key >> rng.counter;
+  f >> bestFixedArea >> bestMaxX >> fixedArea;
+  f >> statistics.v0 >> statistics.iterations >>
+      statistics.numFeasabilityTests >> statistics.numBBTests >>
+      statistics.numBBTestsSucceeded;
+  f >> statistics.numPairTests >> statistics.numPairMemoHits >>
+      statistics.numDuplicatePositions >> statistics.numApproxAccepts >>
+      statistics.numApproxRejects;
+  int n;
+  f >> n;
+  pieceQuantity.resize(n);
+  for (int& q : pieceQuantity)
+    f >> q;
+
+  f >> n;
+  clearLayout();
+  fixed.resize(n);
+  g.resize(n);
+  anchors.resize(n);
+  vector<Point> pts;
+  for (int i = 0; i < n; ++i) {
+    int numVertices;
+    f >> fixed[i].id >> fixed[i].orientation >> numVertices;
+    if (i > 0) {
+      auto& pol = fixed[i].pol;
+      pol.v.resize(numVertices);
+      for (auto& p : pol.v) {
+        f >> p.x >> p.y;
+        pts.push_back(p);
+      }
+      if (fixed[i].orientation >= 0) {
+        /* rebuilt as the search placed it, for the pair memo */
+        const auto& o =
+            problem.pieceOrientations[fixed[i].id][fixed[i].orientation];
+        pol = o.pol.translated(pol.v[0] - o.pol.v[0]);
+      } else {
+        pol.buildEdgeTree();
+      }
+    }
+    int size;
+    f >> size;
+    g[i].resize(size);
+    for (int& a : g[i])
+      f >> a;
+    f >> size;
+    anchors[i].resize(size);
+    for (int& a : anchors[i])
+      f >> a;
+  }
+  assert(not f.fail());
+  chFixed = pts.empty() ? Polygon() : convexHull(pts);
+  commitLayout();
+  problem.timer.restart(elapsed);
+}
+
+Drawing Algorithm::drawing() const {
+  Drawing d;
+  d.plate = problem.plate;
+  for (int i = 1; i < (int)fixed.size(); ++i) {
+    d.pieces.push_back(fixed[i].pol);
+    d.types.push_back(fixed[i].id);
+  }
+  return d;
+}
@@ -23,12 +23,24 @@
  */
 #pragma once
 #include "Problem.h"
+#include "Random.h"
+#include "Render.h"
+#include "Statistics.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <limits>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 struct Algorithm {
+  Algorithm(Problem& problem, Statistics& statistics)
+      : problem(problem), statistics(statistics),
+        workBudget(problem.workBudget) {}
 
   void constructiveGreedy();
 
@@ -36,14 +48,99 @@ struct Algorithm {
 
   void iteratedGreedy();
 
+  /* Iterated greedy with problem.numThreads workers, each repeatedly
+   * destroying and repairing its copy of the shared incumbent */
+  void parallelIteratedGreedy();
+
   void randomPlacementAlgorithm();
 
   void deconstruct();
 
+  /* Resets the layout to the empty plate, discarding the journal */
+  void clearLayout();
+
+  /* The placed pieces, without the plate */
+  std::vector<Polygon> layoutPolygons() const;
+
+  double layoutMaxX() const;
+
+  /* Replaces the layout by the given pieces and commits it. Each piece is
+   * matched to an orientation of a piece of the instance; pieces that match
+   * none, exceed the quantity of their piece or do not fit are dropped. The
+   * contact graph links each piece to one it touches at a vertex. */
+  void adoptLayout(const std::vector<Polygon>& layout);
+
+  /* adoptLayout, if the result scores better than the current layout, which
+   * is kept otherwise: adoptLayout may drop pieces of a layout received from
+   * another island */
+  bool adoptIfBetter(const std::vector<Polygon>& layout);
+
+  /* Reads the pieces of a layout in the format of writeOutput */
+  std::vector<Polygon> readLayout(const std::string& file) const;
+
+  /* prepare() and then search() */
   void run();
 
+  /* Seeds rng from problem.randomSeed, with the stream of this island */
+  void seedRandom();
+
+  /* Resets the search state and starts from the empty plate, or from
+   * problem.initFile */
+  void prepare();
+
+  /* Runs the algorithm selected by the problem on the current layout */
+  void search();
+
   void writeOutput();
 
+  void writeLayout(std::ostream& f) const;
+
+  /* Saves the state of the iterated greedy between two iterations, where the
+   * layout is the incumbent, so that it can be continued from the same
+   * point. The file is replaced atomically. */
+  void writeCheckpoint(const std::string& file, double bestFixedArea,
+                       double bestMaxX) const;
+
+  /* Restores the state saved by writeCheckpoint, including the elapsed time */
+  void readCheckpoint(const std::string& file, double& bestFixedArea,
+                      double& bestMaxX);
+
+  /* false if problem.keepAllPieces is set and constructiveGreedy left some
+   * pieces out */
+  bool layoutComplete() const;
+
+  /* Layouts are compared by placed area, or else by length. Layouts that
+   * keep all pieces have the same area, so they are compared by length. */
+  bool areaObjective() const;
+
+  /* placed area if compaction is optimized, otherwise minus the length */
+  double layoutScore() const;
+
+  /* The layout, with pieces colored by their id */
+  Drawing drawing() const;
+
+  /* true once the time limit or the work budget is reached, or the search
+   * is cancelled */
+  bool stopRequested() const {
+    return cancelled or problem.timeLimitExceeded() or
+           (workBudget > 0 and statistics.work() >= workBudget);
+  }
+
+  /* Placed area no layout can exceed: the plate, or every available piece */
+  double areaBound() const;
+
+  /* Early stopping, called after each iteration with the best layout so far
+   * and the iteration and time of its last improvement: stops the search if
+   * its area reaches areaBound(), or problem.targetUtilization, or if it has
+   * not improved for problem.stagnationIterations iterations or
+   * problem.stagnationSeconds seconds. Unlike stopRequested(), this only
+   * ends the iterations: later constructive fills still run. */
+  void checkEarlyStop(double bestFixedArea, int64_t lastImprovement,
+                      double lastImprovementTime);
+
+  /* why the search stopped, for the statistics */
+  const char* stopReason() const;
+
   struct PiecePlacement {
     PiecePlacement() {}
     PiecePlacement(Polygon&& pol, int floatIndex, double value, int vertex,
@@ -60,21 +157,312 @@ struct Algorithm {
     int vertex = -1;         /* vertex connected to another piece */
     int attached = -1;       /* index of piece that 'pol' is attached to */
     int attachedVertex = -1; /* index of connected vertex in 'attached' */
+    int pieceId = -1;        /* id of the piece in the instance */
+    int angle = -1;          /* index of its orientation */
+  };
+
+  /* The changes of one destroy and repair step: the indices removed by
+   * deconstruct, in the order they were removed, then the placements */
+  struct Repair {
+    std::vector<int> removed;
+    std::vector<PiecePlacement> placed;
+  };
+
+  /* An immutable copy of a layout, shared by the parallel workers. Each
+   * accepted improvement gets the next version. A worker's improvement also
+   * keeps the repair that made it from the previous version, which other
+   * workers replay to re-base on it. */
+  struct Incumbent {
+    uint64_t version;
+    double score; /* higher is better; see layoutScore() */
+    double fixedArea;
+    Polygon chFixed;
+    std::vector<Piece> fixed;
+    std::vector<std::vector<int>> g, anchors;
+    std::weak_ptr<const Incumbent> previous; /* expired if not a repair */
+    Repair repair;
+  };
+
+  std::shared_ptr<Incumbent> snapshot(uint64_t version) const;
+
+  /* Replaces the layout by a copy of the incumbent and commits it */
+  void restore(const Incumbent& incumbent);
+
+  /* Moves the committed layout, which must be that of 'from', to 'to' by
+   * replaying the repairs between them, and commits it. Restores a copy of
+   * 'to' if one of them is no longer available. */
+  void rebase(const Incumbent& from, const std::shared_ptr<const Incumbent>& to);
+
+  /* Worker of parallelIteratedGreedy: destroys and repairs its copy of the
+   * incumbent, and publishes improvements with a compare-and-swap that only
+   * succeeds if the incumbent is still the one the attempt started from. The
+   * atomic operations on shared_ptr take a lock from a small internal pool in
+   * libstdc++, held only for the swap, not for the attempt. */
+  void speculativeRepair(std::shared_ptr<const Incumbent>* incumbent);
+
+  /* Layout changes. Every change to fixed, g and anchors is recorded in the
+   * journal, so that rollbackLayout() can restore the last committed layout
+   * in time proportional to the number of changes made since then. */
+  void placePiece(const PiecePlacement& placement);
+
+  /* Removes fixed[i] (i > 0); the last piece takes its index */
+  void removePiece(int i);
+
+  /* Removes the pieces at the given indices, in that order, as deconstruct
+   * does, and updates anchors, fixedArea and chFixed */
+  void removePieces(const std::vector<int>& indices);
+
+  void commitLayout();
+
+  void rollbackLayout();
+
+  struct LayoutChange {
+    enum Kind { Placed, Removed, EdgeAdded, EdgeErased, EdgeRenamed, Anchors };
+    LayoutChange(Kind kind, int index, int pos = -1, int value = -1)
+        : kind(kind), index(index), pos(pos), value(value) {}
+    Kind kind;
+    int index;      /* index in fixed of the piece that was changed */
+    int pos, value; /* position and old value of an entry of g[index] */
+    Piece piece;    /* removed piece */
+    std::vector<int> adjacency, anchors; /* old g[index], anchors[index] */
+  };
+
+  /* A feasible placement, without its polygon: floating[floatIndex] in
+   * orientation 'angle', with its vertex 'vertex' on vertex 'attachedVertex'
+   * of fixed[attached] */
+  struct Candidate {
+    int floatIndex, angle, vertex, attached, attachedVertex;
+    double value;
+  };
+
+  struct CandidateList {
+    void clear() {
+      records.clear();
+      minValue = std::numeric_limits<double>::max();
+      maxValue = std::numeric_limits<double>::lowest();
+    }
+    void add(const Candidate& c) {
+      records.push_back(c);
+      minValue = std::min(minValue, c.value);
+      maxValue = std::max(maxValue, c.value);
+    }
+    std::vector<Candidate> records;
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+  };
+
+  /* The pieces that may still be placed, in decreasing order of area. A
+   * piece is referred to by its position in that order, which stays valid
+   * while others are removed; removal and reset do not move pieces. */
+  struct FloatingPool {
+    /* sorts the pieces, once per run; all of them are available */
+    void assign(const std::vector<Piece>& all) {
+      pieces = all;
+      std::sort(pieces.begin(), pieces.end(),
+                [](const Piece& a, const Piece& b) {
+                  return a.pol.area() > b.pol.area();
+                });
+      int n = pieces.size();
+      /* circular list through the available positions; n is its head */
+      initialNext.resize(n + 1);
+      initialPrev.resize(n + 1);
+      for (int i = 0; i <= n; ++i) {
+        initialNext[i] = (i + 1) % (n + 1);
+        initialPrev[i] = (i + n) % (n + 1);
+      }
+      reset();
+    }
+
+    /* makes all pieces available again */
+    void reset() {
+      next = initialNext;
+      prev = initialPrev;
+      count = pieces.size();
+    }
+
+    void remove(int pos) {
+      next[prev[pos]] = next[pos];
+      prev[next[pos]] = prev[pos];
+      --count;
+    }
+
+    /* available positions, in order: first(), after(first()), ... end() */
+    int first() const { return next[end()]; }
+    int after(int pos) const { return next[pos]; }
+    int end() const { return pieces.size(); }
+
+    int size() const { return count; }
+
+    const Piece& operator[](int pos) const { return pieces[pos]; }
+
+    std::vector<Piece> pieces;
+    std::vector<int> next, prev, initialNext, initialPrev;
+    int count = 0;
   };
 
-  PiecePlacement
-  selectPiecePlacement(int floatIndex,
-                       std::vector<PiecePlacement>* placements = nullptr);
+  /* Builds the polygon of a candidate */
+  PiecePlacement materialize(const Candidate& c) const;
+
+  PiecePlacement selectPiecePlacement(int floatIndex,
+                                      CandidateList* candidates = nullptr) {
+    return (this->*selectKernel)(floatIndex, candidates);
+  }
+
+  /* 'type' and 'angle' may identify pol as a translated orientation of a
+   * piece, which allows the pairwise tests to be memoized */
+  bool isFeasible(const Polygon& pol, int type = -1, int angle = -1) const {
+    return (this->*feasibleKernel)(pol, type, angle);
+  }
+
+  /* Binds selectPiecePlacement and isFeasible to the kernels specialized for
+   * the objective, plate shape and bounding-box setting of the problem */
+  void bindKernels();
+
+  template <typename Policy>
+  PiecePlacement selectPiecePlacementKernel(int floatIndex,
+                                            CandidateList* candidates);
 
-  bool isFeasible(const Polygon& pol) const;
+  /* Tries the orientation ai of floating[floatIndex] at every anchor,
+   * updating bestPlacement and candidates; returns the best value found */
+  template <typename Policy>
+  double tryOrientation(int floatIndex, int ai, PiecePlacement& bestPlacement,
+                        CandidateList* candidates);
 
-  double objective(Polygon& pol);
+  template <typename Policy>
+  bool isFeasibleKernel(const Polygon& pol, int type, int angle) const;
+
+  template <typename Policy> double objectiveKernel(Polygon& pol);
+
+  PiecePlacement (Algorithm::*selectKernel)(int, CandidateList*) = nullptr;
+  bool (Algorithm::*feasibleKernel)(const Polygon&, int, int) const = nullptr;
+
+  /* Whether two placed orientations overlap depends only on their relative
+   * position, which repeats across steps and iterations: the copies of a
+   * piece share their orientations, and most of the layout survives each
+   * deconstruction. The offset is quantized to EPS, the tolerance of the
+   * geometric tests. */
+  struct RelativePose {
+    int typeA, angleA, typeB, angleB;
+    int64_t dx, dy;
+    bool operator==(const RelativePose& p) const {
+      return typeA == p.typeA and angleA == p.angleA and typeB == p.typeB and
+             angleB == p.angleB and dx == p.dx and dy == p.dy;
+    }
+  };
+
+  struct RelativePoseHash {
+    size_t operator()(const RelativePose& p) const {
+      uint64_t h = p.typeA;
+      for (uint64_t x : {(uint64_t)p.angleA, (uint64_t)p.typeB,
+                         (uint64_t)p.angleB, (uint64_t)p.dx, (uint64_t)p.dy})
+        h = (h ^ x) * 0x100000001B3ULL;
+      return h ^ (h >> 29);
+    }
+  };
+
+  /* overlap of each pair of orientations tested so far; cleared when it
+   * reaches maxPairMemo entries, about 70 MB. Each Algorithm has its own:
+   * one per thread of the parallel search and one per sheet. */
+  mutable std::unordered_map<RelativePose, bool, RelativePoseHash> pairMemo;
+  static const size_t maxPairMemo = 1 << 20;
+
+  /* the piece being tested, moved into the frame of a pairMemo key */
+  mutable Polygon pairFrame;
+
+  /* Distinct vertex pairs often attach an orientation at the same position:
+   * collinear plate vertices from super sampling, vertices shared by
+   * touching pieces, symmetric pieces. selectPiecePlacement tests each
+   * position once, keeping the first pair for the contact graph. */
+  struct TriedPosition {
+    int angle;
+    int64_t dx, dy; /* translation, quantized to EPS */
+    bool operator==(const TriedPosition& p) const {
+      return angle == p.angle and dx == p.dx and dy == p.dy;
+    }
+  };
+
+  struct TriedPositionHash {
+    size_t operator()(const TriedPosition& p) const {
+      uint64_t h = p.angle;
+      for (uint64_t x : {(uint64_t)p.dx, (uint64_t)p.dy})
+        h = (h ^ x) * 0x100000001B3ULL;
+      return h ^ (h >> 29);
+    }
+  };
+
+  /* Open-addressing set of the positions tried by the current
+   * selectPiecePlacement. Candidates are many and mostly distinct, so
+   * inserting must not allocate and clearing must not touch the slots:
+   * slots stamped with an older generation are empty. */
+  struct PositionSet {
+    void clear() {
+      count = 0;
+      if (++generation == 0) {
+        /* wrapped around: the stamps could look current */
+        std::fill(stamps.begin(), stamps.end(), 0);
+        generation = 1;
+      }
+    }
+
+    /* false if p is already in the set */
+    bool insert(const TriedPosition& p);
+
+    std::vector<TriedPosition> slots;
+    std::vector<uint32_t> stamps;
+    uint32_t generation = 1;
+    int count = 0;
+  };
+
+  PositionSet triedPositions;
+
+  /* coarse-to-fine rotation search of the current selectPiecePlacement:
+   * best value of each orientation tried, and the ones refined next */
+  std::vector<double> orientationValue;
+  std::vector<bool> orientationTried;
+  std::vector<int> bestOrientations;
+
+  /* true if the directions around u are all covered by fixed pieces or by
+   * the outside of the plate, so no piece can be attached at u */
+  bool anchorIsDead(const Point& u) const;
+
+  /* Re-evaluates the vertices of fixed[pci] inside 'region'; the others keep
+   * their current state */
+  void refreshAnchors(int pci, const Polygon::BB& region);
 
   double fixedArea = 0.0;
   Polygon chFixed;
-  std::vector<Piece> floating, fixed;
+  FloatingPool floating;
+  std::vector<Piece> fixed;
   std::vector<int> pieceQuantity;
   std::vector<std::vector<int>> g;
-};
 
-extern Algorithm alg;
\ No newline at end of file
+  /* anchors[i] holds the vertices of fixed[i], in increasing order, that lie
+   * on the boundary of the free space; pieces are only attached at these */
+  std::vector<std::vector<int>> anchors;
+
+  Problem& problem;
+  Statistics& statistics;
+
+  /* random stream of this search, derived from the seed in run() */
+  RNG rng;
+
+  /* work units this search may use (see Statistics::work); 0: no limit.
+   * problem.workBudget, or a share of it for a parallel worker */
+  int64_t workBudget;
+
+  /* may be set from another thread to stop the search */
+  std::atomic<bool> cancelled{false};
+
+  /* set by checkEarlyStop; nullptr while the iterations go on */
+  const char* finishReason = nullptr;
+
+  /* called with the new incumbent whenever the search improves it */
+  std::function<void(const Algorithm&)> onImprovement;
+
+  /* if set, deconstruct and placePiece record their changes into it */
+  Repair* repairLog = nullptr;
+
+  std::vector<LayoutChange> journal;
+  double committedFixedArea = 0.0;
+  Polygon committedChFixed;
+};
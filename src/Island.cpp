@@ -0,0 +1,326 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Island.h"
+#include "Print.h"
+#include "Timer.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+IslandModel islands;
+
+#ifndef _WIN32
+
+namespace {
+string encodeLayout(double score, const vector<Polygon>& layout) {
+  ostringstream ss;
+  ss << setprecision(17) << score << "\n" << layout.size() << "\n";
+  for (auto& pol : layout) {
+    ss << pol.v.size() << "\n";
+    for (auto& p : pol.v)
+      ss << p.x << " " << p.y << "\n";
+  }
+  return ss.str();
+}
+
+double decodeLayout(const string& s, vector<Polygon>& layout) {
+  istringstream ss(s);
+  double score;
+  int numPolygons;
+  ss >> score >> numPolygons;
+  layout.assign(numPolygons, Polygon());
+  for (auto& pol : layout) {
+    int numVertices;
+    ss >> numVertices;
+    pol.v.resize(numVertices);
+    for (auto& p : pol.v)
+      ss >> p.x >> p.y;
+  }
+  return score;
+}
+
+double decodeScore(const string& s) {
+  istringstream ss(s);
+  double score = -1e300;
+  ss >> score;
+  return score;
+}
+
+bool readFully(int fd, char* buf, size_t n) {
+  while (n > 0) {
+    ssize_t r = read(fd, buf, n);
+    if (r < 0 and errno == EINTR) continue;
+    if (r <= 0) return false;
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+bool writeFully(int fd, const char* buf, size_t n) {
+  while (n > 0) {
+    ssize_t r = send(fd, buf, n, MSG_NOSIGNAL);
+    if (r < 0 and errno == EINTR) continue;
+    if (r <= 0) return false;
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+bool readable(int fd, int timeoutMs) {
+  pollfd p = {fd, POLLIN, 0};
+  return poll(&p, 1, timeoutMs) > 0;
+}
+
+sockaddr_un socketAddress(const string& path) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+} // namespace
+
+void IslandModel::start(const string& socketPath, int numIslands, int id) {
+  this->numIslands = numIslands;
+  this->id = id;
+  path = socketPath;
+  if (not enabled()) return;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  auto addr = socketAddress(path);
+  if (isCoordinator()) {
+    unlink(path.c_str());
+    if (fd < 0 or bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 or
+        listen(fd, numIslands) != 0) {
+      printlnForced("island 0: could not listen on ", path, ": ",
+                    strerror(errno), "; running alone");
+      this->numIslands = 1;
+      return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    println("island 0: coordinating ", numIslands, " islands on ", path);
+  } else {
+    /* the coordinator may not be up yet */
+    for (int attempt = 0; attempt < 300; ++attempt) {
+      if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        println("island ", id, ": connected to ", path);
+        return;
+      }
+      this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    printlnForced("island ", id, ": could not connect to ", path,
+                  "; running alone");
+    close(fd);
+    fd = -1;
+    this->numIslands = 1;
+  }
+}
+
+void IslandModel::acceptClients() {
+  int c;
+  while ((c = accept(fd, nullptr, nullptr)) >= 0) {
+    clients.push_back({c, -1e300, false});
+  }
+}
+
+bool IslandModel::readMessage(int fd, MessageType& type, string& payload) {
+  char header[1 + sizeof(uint32_t)];
+  if (not readFully(fd, header, sizeof(header))) return false;
+  uint32_t length;
+  memcpy(&length, header + 1, sizeof(length));
+  type = MessageType(header[0]);
+  payload.resize(length);
+  return length == 0 or readFully(fd, &payload[0], length);
+}
+
+void IslandModel::sendMessage(int fd, MessageType type, const string& payload) {
+  char header[1 + sizeof(uint32_t)];
+  uint32_t length = payload.size();
+  header[0] = type;
+  memcpy(header + 1, &length, sizeof(length));
+  writeFully(fd, header, sizeof(header)) and
+      writeFully(fd, payload.data(), payload.size());
+}
+
+void IslandModel::receive(Client& c, MessageType type, const string& payload) {
+  double score = decodeScore(payload);
+  c.lastScore = max(c.lastScore, score);
+  if (score > bestScore) {
+    bestScore = score;
+    bestLayout = payload;
+  }
+  if (type == Final) c.finished = true;
+}
+
+bool IslandModel::migrate(double score, const vector<Polygon>& layout,
+                          vector<Polygon>& elite, double& eliteScore) {
+  if (not enabled()) return false;
+
+  if (isCoordinator()) {
+    if (score > bestScore) {
+      bestScore = score;
+      bestLayout = encodeLayout(score, layout);
+    }
+    acceptClients();
+    for (auto& c : clients) {
+      MessageType type;
+      string payload;
+      while (not c.finished and readable(c.fd, 0)) {
+        if (readMessage(c.fd, type, payload)) {
+          receive(c, type, payload);
+        } else {
+          c.finished = true;
+        }
+      }
+    }
+    /* send the elite to every island that is behind it */
+    for (auto& c : clients) {
+      if (not c.finished and bestScore > c.lastScore) {
+        sendMessage(c.fd, Elite, bestLayout);
+        c.lastScore = bestScore;
+        ++migrationsSent;
+      }
+    }
+    if (bestScore > score) {
+      eliteScore = decodeLayout(bestLayout, elite);
+      ++migrationsReceived;
+      return true;
+    }
+    return false;
+  }
+
+  sendMessage(fd, Offer, encodeLayout(score, layout));
+  ++migrationsSent;
+  string best;
+  eliteScore = score;
+  MessageType type;
+  string payload;
+  while (readable(fd, 0) and readMessage(fd, type, payload)) {
+    double s = decodeScore(payload);
+    if (type == Elite and s > eliteScore) {
+      eliteScore = s;
+      best = move(payload);
+    }
+  }
+  if (best.empty()) return false;
+  decodeLayout(best, elite);
+  ++migrationsReceived;
+  return true;
+}
+
+bool IslandModel::finish(double score, const vector<Polygon>& layout,
+                         vector<Polygon>& elite, double& eliteScore) {
+  if (not enabled()) return false;
+
+  if (not isCoordinator()) {
+    sendMessage(fd, Final, encodeLayout(score, layout));
+    close(fd);
+    fd = -1;
+    return false;
+  }
+
+  if (score > bestScore) {
+    bestScore = score;
+    bestLayout = encodeLayout(score, layout);
+  }
+
+  /* wait for the final layouts of all other islands, for at most a minute */
+  println("island 0: waiting for the other islands");
+  Timer<> waiting;
+  auto finishedClients = [&]() {
+    int n = 0;
+    for (auto& c : clients)
+      n += c.finished;
+    return n;
+  };
+  while (finishedClients() < numIslands - 1 and timerSeconds(waiting) < 60) {
+    acceptClients();
+    vector<pollfd> fds;
+    for (auto& c : clients) {
+      if (not c.finished) fds.push_back({c.fd, POLLIN, 0});
+    }
+    if (fds.empty() or poll(fds.data(), fds.size(), 100) <= 0) {
+      if (fds.empty()) this_thread::sleep_for(chrono::milliseconds(100));
+      continue;
+    }
+    for (auto& c : clients) {
+      MessageType type;
+      string payload;
+      if (c.finished or not readable(c.fd, 0)) continue;
+      if (readMessage(c.fd, type, payload)) {
+        receive(c, type, payload);
+      } else {
+        c.finished = true;
+      }
+    }
+  }
+  for (auto& c : clients)
+    close(c.fd);
+  clients.clear();
+  close(fd);
+  fd = -1;
+  unlink(path.c_str());
+
+  if (bestScore > score) {
+    eliteScore = decodeLayout(bestLayout, elite);
+    ++migrationsReceived;
+    return true;
+  }
+  return false;
+}
+
+#else
+
+void IslandModel::start(const string&, int numIslands, int) {
+  if (numIslands > 1) {
+    printlnForced("the island model is not supported on this platform");
+  }
+  this->numIslands = 1;
+}
+
+bool IslandModel::migrate(double, const vector<Polygon>&, vector<Polygon>&,
+                          double&) {
+  return false;
+}
+
+bool IslandModel::finish(double, const vector<Polygon>&, vector<Polygon>&,
+                         double&) {
+  return false;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include "Polygon.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Island model: several processes run the iterated greedy on the same
+ * instance and exchange their best layouts through a Unix domain socket.
+ * Island 0 is the coordinator: it owns the socket, keeps the best layout
+ * seen by any island, and writes the final output. Scores are maximized. */
+struct IslandModel {
+  bool enabled() const { return numIslands > 1; }
+
+  bool isCoordinator() const { return id == 0; }
+
+  /* Coordinator: creates the socket. Others: connect to it, waiting for the
+   * coordinator to come up. */
+  void start(const std::string& socketPath, int numIslands, int id);
+
+  /* Shares our incumbent and collects the ones sent by other islands. Returns
+   * true, filling 'elite', if a layout better than 'score' is available. */
+  bool migrate(double score, const std::vector<Polygon>& layout,
+               std::vector<Polygon>& elite, double& eliteScore);
+
+  /* Islands other than the coordinator send their final layout; the
+   * coordinator waits for all of them and returns true if one of them is
+   * better than 'score'. */
+  bool finish(double score, const std::vector<Polygon>& layout,
+              std::vector<Polygon>& elite, double& eliteScore);
+
+  int numIslands = 1, id = 0;
+  int64_t migrationsSent = 0, migrationsReceived = 0;
+
+private:
+  enum MessageType : char { Offer = 'O', Elite = 'E', Final = 'F' };
+
+  struct Client {
+    int fd;
+    double lastScore;
+    bool finished;
+  };
+
+  void acceptClients();
+  bool readMessage(int fd, MessageType& type, std::string& payload);
+  void sendMessage(int fd, MessageType type, const std::string& payload);
+  void receive(Client& c, MessageType type, const std::string& payload);
+
+  std::string path;
+  int fd = -1; /* listening socket (coordinator) or connection to it */
+  std::vector<Client> clients;
+  double bestScore = -1e300;
+  std::string bestLayout;
+};
+
+extern IslandModel islands;
@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Log.h"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+atomic<int> logLevel(LogInfo);
+
+Logger logger;
+
+bool parseLogLevel(const string& name, int& level) {
+  const char* names[] = {"error", "warning", "info", "debug"};
+  for (int i = 0; i < 4; ++i) {
+    if (name == names[i]) {
+      level = LogError + i;
+      return true;
+    }
+  }
+  return false;
+}
+
+Logger::Logger() {
+  for (size_t i = 0; i < capacity; ++i)
+    slots[i].sequence.store(i, memory_order_relaxed);
+  thread = std::thread([this] { drain(); });
+}
+
+Logger::~Logger() {
+  stopping = true;
+  thread.join();
+}
+
+size_t Logger::claim() {
+  size_t pos = writePos.load(memory_order_relaxed);
+  while (true) {
+    size_t seq = slots[pos & mask].sequence.load(memory_order_acquire);
+    if (seq == pos) {
+      if (writePos.compare_exchange_weak(pos, pos + 1,
+                                         memory_order_relaxed))
+        return pos;
+    } else if (seq < pos) {
+      /* full: the slot still holds a message to write */
+      this_thread::yield();
+      pos = writePos.load(memory_order_relaxed);
+    } else {
+      pos = writePos.load(memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::flush() {
+  size_t target = writePos.load(memory_order_acquire);
+  while (written.load(memory_order_acquire) < target)
+    this_thread::sleep_for(chrono::microseconds(100));
+}
+
+void Logger::drain() {
+  while (true) {
+    /* read before draining, so that the last messages are not missed */
+    bool stop = stopping;
+    size_t n = 0;
+    while (true) {
+      Slot& s = slots[readPos & mask];
+      if (s.sequence.load(memory_order_acquire) != readPos + 1) break;
+      print(s.record);
+      s.sequence.store(readPos + capacity, memory_order_release);
+      ++readPos, ++n;
+    }
+    if (n > 0) {
+      cout.flush();
+      written.store(readPos, memory_order_release);
+    } else if (stop) {
+      return;
+    } else {
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+  }
+}
+
+void Logger::print(const LogRecord& r) {
+  if (r.tag[0]) cout << '[' << r.tag << "] ";
+  for (int i = 0; i < r.numArgs; ++i) {
+    const LogRecord::Arg& a = r.args[i];
+    switch (a.kind) {
+    case LogRecord::Arg::Int:
+      cout << a.i;
+      break;
+    case LogRecord::Arg::UInt:
+      cout << a.u;
+      break;
+    case LogRecord::Arg::Double:
+      cout << a.d;
+      break;
+    case LogRecord::Arg::Char:
+      cout << a.c;
+      break;
+    case LogRecord::Arg::Text:
+      cout.write(r.text + a.offset, a.length);
+      break;
+    case LogRecord::Arg::LongText:
+      cout << *a.s;
+      delete a.s;
+      break;
+    }
+  }
+  if (r.newline) cout << '\n';
+}
@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+/* Leveled, asynchronous logging. A message is captured into a slot of a
+ * lock-free ring buffer, numbers as they are and strings copied, and a
+ * background thread formats it and writes it to stdout, so that the searching
+ * threads neither format nor flush. Messages above CUT_LOG_LEVEL are compiled
+ * out (e.g. make DEFINES=-DCUT_LOG_LEVEL=2); the others are filtered at run
+ * time by logLevel and, for info and debug, muted on threads where
+ * silentOutput() is set. Each line is prefixed by the tag of its thread, if
+ * it has one. */
+enum LogLevel { LogAlways, LogError, LogWarning, LogInfo, LogDebug };
+
+#ifndef CUT_LOG_LEVEL
+#define CUT_LOG_LEVEL 4 /* LogDebug */
+#endif
+
+/* Logs a line; unlike println, the arguments are not evaluated when the
+ * level is compiled out or filtered */
+#define LOG(level, ...)                                                        \
+  do {                                                                         \
+    if ((level) <= CUT_LOG_LEVEL and logEnabled(level))                        \
+      logger.write(level, true, __VA_ARGS__);                                  \
+  } while (false)
+
+/* Whether print and println are muted on this thread; each Solver sets it
+ * from its problem's 'silent' option while it runs */
+inline bool& silentOutput() {
+  static thread_local bool silent = false;
+  return silent;
+}
+
+/* Mutes this thread for the enclosing scope if 'silent' is set, e.g. for
+ * the work a Problem with the silent option does on the caller's thread */
+struct SilentScope {
+  explicit SilentScope(bool silent) : previous(silentOutput()) {
+    silentOutput() = previous or silent;
+  }
+  ~SilentScope() { silentOutput() = previous; }
+  bool previous;
+};
+
+/* Prefix of the lines logged by this thread, at most 15 characters */
+inline char* logTag() {
+  static thread_local char tag[16] = "";
+  return tag;
+}
+
+inline void setLogTag(const std::string& tag) {
+  std::strncpy(logTag(), tag.c_str(), 15);
+  logTag()[15] = '\0';
+}
+
+extern std::atomic<int> logLevel;
+
+inline bool logEnabled(LogLevel level) {
+  return level == LogAlways or
+         (level <= logLevel.load(std::memory_order_relaxed) and
+          (level <= LogWarning or not silentOutput()));
+}
+
+/* "error", "warning", "info" or "debug"; false if 'name' is none of them */
+bool parseLogLevel(const std::string& name, int& level);
+
+/* A message as captured by the logging thread */
+struct LogRecord {
+  static const int maxArgs = 12, textSize = 192;
+
+  struct Arg {
+    enum Kind : uint8_t { Int, UInt, Double, Char, Text, LongText } kind;
+    uint16_t offset, length; /* of a Text in 'text' */
+    union {
+      int64_t i;
+      uint64_t u;
+      double d;
+      char c;
+      std::string* s; /* LongText, deleted once written */
+    };
+  };
+
+  void addInt(int64_t i) { args[numArgs].i = i, add(Arg::Int); }
+  void addUInt(uint64_t u) { args[numArgs].u = u, add(Arg::UInt); }
+  void addDouble(double d) { args[numArgs].d = d, add(Arg::Double); }
+  void addChar(char c) { args[numArgs].c = c, add(Arg::Char); }
+
+  /* Strings that do not fit in 'text' are copied to the heap */
+  void addText(const char* s, size_t n) {
+    if (textUsed + n > (size_t)textSize) {
+      args[numArgs].s = new std::string(s, n);
+      add(Arg::LongText);
+      return;
+    }
+    std::memcpy(text + textUsed, s, n);
+    args[numArgs].offset = textUsed;
+    args[numArgs].length = n;
+    textUsed += n;
+    add(Arg::Text);
+  }
+
+  void add(Arg::Kind kind) { args[numArgs++].kind = kind; }
+
+  uint8_t level;
+  bool newline;
+  uint8_t numArgs;
+  uint16_t textUsed;
+  char tag[16];
+  Arg args[maxArgs];
+  char text[textSize];
+};
+
+/* How each type of argument is captured: others than numbers, characters
+ * and strings are formatted by the calling thread */
+template <typename T, typename = void> struct LogCapture {
+  static void add(LogRecord& r, const T& v) {
+    std::ostringstream s;
+    s << v;
+    std::string str = s.str();
+    r.addText(str.data(), str.size());
+  }
+};
+
+template <typename T>
+struct LogCapture<T, typename std::enable_if<std::is_integral<T>::value and
+                                             std::is_signed<T>::value>::type> {
+  static void add(LogRecord& r, T v) { r.addInt(v); }
+};
+
+template <typename T>
+struct LogCapture<T, typename std::enable_if<std::is_integral<T>::value and
+                                             std::is_unsigned<T>::value>::type> {
+  static void add(LogRecord& r, T v) { r.addUInt(v); }
+};
+
+template <typename T>
+struct LogCapture<
+    T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static void add(LogRecord& r, T v) { r.addDouble(v); }
+};
+
+template <> struct LogCapture<char> {
+  static void add(LogRecord& r, char c) { r.addChar(c); }
+};
+
+template <size_t N> struct LogCapture<char[N]> {
+  static void add(LogRecord& r, const char* s) {
+    r.addText(s, std::strlen(s));
+  }
+};
+
+template <> struct LogCapture<const char*> {
+  static void add(LogRecord& r, const char* s) {
+    r.addText(s, std::strlen(s));
+  }
+};
+
+template <> struct LogCapture<char*> : LogCapture<const char*> {};
+
+template <> struct LogCapture<std::string> {
+  static void add(LogRecord& r, const std::string& s) {
+    r.addText(s.data(), s.size());
+  }
+};
+
+/* The ring buffer and its writing thread. Producers claim a slot with a
+ * compare-and-swap on the write position and publish it through the slot's
+ * sequence number; when the buffer is full they wait for the writer. */
+struct Logger {
+  Logger();
+  ~Logger();
+
+  template <typename... Args>
+  void write(LogLevel level, bool newline, const Args&... args) {
+    static_assert(sizeof...(Args) <= LogRecord::maxArgs,
+                  "too many arguments for one log message");
+    size_t pos = claim();
+    LogRecord& r = slots[pos & mask].record;
+    r.level = level;
+    r.newline = newline;
+    r.numArgs = 0;
+    r.textUsed = 0;
+    std::memcpy(r.tag, logTag(), sizeof r.tag);
+    int expand[] = {0, (LogCapture<Args>::add(r, args), 0)...};
+    (void)expand;
+    slots[pos & mask].sequence.store(pos + 1, std::memory_order_release);
+    if (level == LogError) flush();
+  }
+
+  /* Waits until the messages logged so far are written */
+  void flush();
+
+private:
+  static const size_t capacity = 1024, mask = capacity - 1;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+  };
+
+  size_t claim();
+  void drain();
+  void print(const LogRecord& r);
+
+  Slot slots[capacity];
+  std::atomic<size_t> writePos{0};
+  size_t readPos = 0; /* only used by the writing thread */
+  std::atomic<size_t> written{0};
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+extern Logger logger;
@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Memory.h"
+#include "Print.h"
+#include <fstream>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+MemoryProfiler memoryProfiler;
+
+void MemoryProfiler::open(const string& file) {
+  this->file = file;
+  enabled = true;
+}
+
+const char* MemoryProfiler::phaseName(int phase) {
+  static const char* names[NumPhases] = {
+      "other",       "search",      "constructive", "deconstruct",
+      "objective",   "feasibility", "io"};
+  return names[phase];
+}
+
+int64_t MemoryProfiler::peakRSS() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    return int64_t(usage.ru_maxrss) * 1024; /* kilobytes on Linux */
+#endif
+  return 0;
+}
+
+void MemoryProfiler::print() const {
+  for (int i = 0; i < NumPhases; ++i) {
+    println("--statistic memory-", phaseName(i), "-allocations ",
+            phases[i].allocations.load());
+    println("--statistic memory-", phaseName(i), "-bytes ",
+            phases[i].bytes.load());
+  }
+  println("--statistic memory-live-bytes ", live.load());
+  println("--statistic memory-peak-live-bytes ", peakLive.load());
+  println("--statistic memory-peak-rss ", peakRSS());
+}
+
+void MemoryProfiler::write() const {
+  ofstream f(file);
+  if (f.fail()) {
+    printlnForced("could not write memory profile to ", file);
+    return;
+  }
+  f << "{\n  \"phases\": {\n";
+  for (int i = 0; i < NumPhases; ++i) {
+    f << "    \"" << phaseName(i)
+      << "\": {\"allocations\": " << phases[i].allocations.load()
+      << ", \"bytes\": " << phases[i].bytes.load() << "}"
+      << (i + 1 < NumPhases ? ",\n" : "\n");
+  }
+  f << "  },\n  \"liveBytes\": " << live.load()
+    << ",\n  \"peakLiveBytes\": " << peakLive.load()
+    << ",\n  \"peakRSS\": " << peakRSS() << "\n}\n";
+}
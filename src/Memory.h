@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include "Trace.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* Heap accounting by phase of the solver, enabled by open(). The global
+ * operator new and delete of MemoryHooks.cpp, which only cut links, then
+ * count the allocations and bytes of the phase set on the calling thread,
+ * and the live bytes and their peak across all threads. When disabled, an
+ * allocation costs one branch. Bytes are those of the blocks handed out by
+ * malloc, so they include its rounding. */
+struct MemoryProfiler {
+  enum Phase {
+    Other,
+    Search, /* layouts kept, committed and restored by the searches */
+    Constructive,
+    Deconstruct,
+    Objective,
+    Feasibility,
+    IO,
+    NumPhases
+  };
+
+  struct Counters {
+    std::atomic<int64_t> allocations{0}, bytes{0};
+  };
+
+  void open(const std::string& file);
+
+  void allocated(size_t bytes) {
+    auto& c = phases[phase()];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    int64_t now = live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    int64_t peak = peakLive.load(std::memory_order_relaxed);
+    while (now > peak and not peakLive.compare_exchange_weak(
+                              peak, now, std::memory_order_relaxed))
+      ;
+  }
+
+  void freed(size_t bytes) {
+    live.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  /* phase of the calling thread */
+  static Phase& phase() {
+    static thread_local Phase p = Other;
+    return p;
+  }
+
+  static const char* phaseName(int phase);
+
+  /* peak resident set size of the process, in bytes (0 if unknown) */
+  static int64_t peakRSS();
+
+  /* as --statistic lines */
+  void print() const;
+
+  /* as JSON, to the file given to open() */
+  void write() const;
+
+  bool enabled = false;
+  Counters phases[NumPhases];
+  std::atomic<int64_t> live{0}, peakLive{0};
+
+private:
+  std::string file;
+};
+
+extern MemoryProfiler memoryProfiler;
+
+/* Attributes the allocations of the enclosing scope to a phase */
+struct MemoryPhase {
+  explicit MemoryPhase(MemoryProfiler::Phase p)
+      : previous(MemoryProfiler::phase()) {
+    MemoryProfiler::phase() = p;
+  }
+  ~MemoryPhase() { MemoryProfiler::phase() = previous; }
+  MemoryProfiler::Phase previous;
+};
+
+#define MEMORY_PHASE(phase)                                                    \
+  MemoryPhase TRACE_CONCAT(memoryPhase, __LINE__)(MemoryProfiler::phase)
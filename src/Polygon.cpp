@@ -79,6 +79,7 @@ Polygon Polygon::translated(const Point& p) const {
   if (cp.centroid_ != Point::infinity()) {
     cp.centroid_ = cp.centroid_.translated(p);
   }
+  cp.treeOffset += p;
   cp.reset_bb();
   return cp;
 }
@@ -90,10 +91,66 @@ Polygon Polygon::rotated(double theta) const {
   if (cp.centroid_ != Point::infinity()) {
     cp.centroid_ = cp.centroid_.rotated(theta);
   }
+  cp.edgeTree.reset();
+  cp.treeOffset = Point(0, 0);
   cp.reset_bb();
   return cp;
 }
 
+namespace {
+const int edgeTreeLeafSize = 4;
+
+void splitEdgeTreeNode(EdgeTree& t, int ni) {
+  int first = t.nodes[ni].first, last = t.nodes[ni].last;
+  if (last - first <= edgeTreeLeafSize) return;
+  int mid = (first + last) / 2;
+  int child = t.nodes.size();
+  t.nodes[ni].child = child;
+  t.nodes.push_back({0, 0, 0, 0, first, mid, -1});
+  t.nodes.push_back({0, 0, 0, 0, mid, last, -1});
+  splitEdgeTreeNode(t, child);
+  splitEdgeTreeNode(t, child + 1);
+}
+} // namespace
+
+void Polygon::buildEdgeTree() {
+  edgeTree.reset();
+  treeOffset = Point(0, 0);
+  reset_bb();
+  if (v.empty()) return;
+
+  auto t = make_shared<EdgeTree>();
+  t->nodes.reserve(4 * v.size() / edgeTreeLeafSize + 1);
+  t->nodes.push_back({0, 0, 0, 0, 0, (int)v.size(), -1});
+  splitEdgeTreeNode(*t, 0);
+
+  /* children are always created after their parent, so computing the boxes
+   * backwards visits children first */
+  for (int ni = t->nodes.size() - 1; ni >= 0; --ni) {
+    auto& n = t->nodes[ni];
+    n.left = n.bottom = DBL_MAX;
+    n.right = n.top = -DBL_MAX;
+    if (n.child == -1) {
+      for (int i = n.first; i <= n.last; ++i) {
+        const auto& p = v[i % v.size()];
+        n.left = min(n.left, p.x);
+        n.right = max(n.right, p.x);
+        n.bottom = min(n.bottom, p.y);
+        n.top = max(n.top, p.y);
+      }
+    } else {
+      for (int c = n.child; c <= n.child + 1; ++c) {
+        const auto& m = t->nodes[c];
+        n.left = min(n.left, m.left);
+        n.right = max(n.right, m.right);
+        n.bottom = min(n.bottom, m.bottom);
+        n.top = max(n.top, m.top);
+      }
+    }
+  }
+  edgeTree = move(t);
+}
+
 Polygon convexHull(std::vector<Point> P) {
 
   int n = P.size(), k = 0;
@@ -132,6 +189,60 @@ bool boundingBoxesIntersect(const Polygon& a, const Polygon& b) {
   return true;                            // boxes overlap
 }
 
+bool edgesIntersect(const Polygon& a, const Polygon& b) {
+  int na = a.v.size(), nb = b.v.size();
+
+  if (not a.edgeTree or not b.edgeTree) {
+    for (int k = 0; k < na; ++k) {
+      auto &p1 = a.v[k], &q1 = a.v[(k + 1) % na];
+      for (int j = 0; j < nb; ++j) {
+        auto &p2 = b.v[j], &q2 = b.v[(j + 1) % nb];
+        if (lineSegmentsIntersect(p1, q1, p2, q2)) return true;
+      }
+    }
+    return false;
+  }
+
+  /* Traverse both trees together, with b's boxes moved into the frame of a's
+   * tree. Boxes are enlarged by EPS, since they were computed before the
+   * vertices were translated. Each tree has depth at most 31, so the stack
+   * never holds more than 64 pairs. */
+  const auto& ta = a.edgeTree->nodes;
+  const auto& tb = b.edgeTree->nodes;
+  Point d = b.treeOffset - a.treeOffset;
+  int stack[64][2];
+  int top = 0;
+  stack[top][0] = 0, stack[top][1] = 0, ++top;
+  while (top > 0) {
+    --top;
+    const auto& x = ta[stack[top][0]];
+    const auto& y = tb[stack[top][1]];
+    if (x.right + EPS < y.left + d.x or x.left - EPS > y.right + d.x or
+        x.top + EPS < y.bottom + d.y or x.bottom - EPS > y.top + d.y)
+      continue;
+
+    if (x.child == -1 and y.child == -1) {
+      for (int k = x.first; k < x.last; ++k) {
+        auto &p1 = a.v[k], &q1 = a.v[(k + 1) % na];
+        for (int j = y.first; j < y.last; ++j) {
+          auto &p2 = b.v[j], &q2 = b.v[(j + 1) % nb];
+          if (lineSegmentsIntersect(p1, q1, p2, q2)) return true;
+        }
+      }
+    } else if (y.child == -1 or
+               (x.child != -1 and x.last - x.first >= y.last - y.first)) {
+      int yi = stack[top][1];
+      stack[top][0] = x.child, stack[top][1] = yi, ++top;
+      stack[top][0] = x.child + 1, stack[top][1] = yi, ++top;
+    } else {
+      int xi = stack[top][0];
+      stack[top][0] = xi, stack[top][1] = y.child, ++top;
+      stack[top][0] = xi, stack[top][1] = y.child + 1, ++top;
+    }
+  }
+  return false;
+}
+
 bool pointInRectangle(const Point& p, double left, double right, double top,
                       double bottom) {
   return p.x >= left and p.x <= right and p.y <= top and p.y >= bottom;
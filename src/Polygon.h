@@ -25,8 +25,21 @@
 #include "Point.h"
 #include <algorithm>
 #include <cfloat>
+#include <memory>
 #include <vector>
 
+/* Bounding-volume hierarchy over the edges of a polygon. Edge i goes from v[i]
+ * to v[(i + 1) % v.size()]; consecutive edges are grouped, since they are
+ * close to each other along the boundary. */
+struct EdgeTree {
+  struct Node {
+    double left, right, top, bottom;
+    int first, last; /* range of edges [first, last) */
+    int child;       /* first child; the second is child + 1. -1 if leaf */
+  };
+  std::vector<Node> nodes;
+};
+
 struct Polygon {
   Polygon() {}
 
@@ -54,8 +67,16 @@ struct Polygon {
 
   Polygon rotated(double theta) const;
 
+  /* Builds the edge tree for the current vertices. Translated copies share it
+   * (only treeOffset changes), so it should be built once per orientation,
+   * and v should not be modified afterwards. */
+  void buildEdgeTree();
+
   std::vector<Point> v;
 
+  std::shared_ptr<const EdgeTree> edgeTree;
+  Point treeOffset; /* translation of v since the edge tree was built */
+
   struct BB {
     double left = DBL_MAX, right = DBL_MAX, top = DBL_MAX, bottom = DBL_MAX;
   };
@@ -70,6 +91,14 @@ struct Polygon {
   const BB& get_bb() {
     if (bb.left == DBL_MAX) {
       reset_bb();
+      if (edgeTree) {
+        const auto& root = edgeTree->nodes[0];
+        bb.left = root.left + treeOffset.x;
+        bb.right = root.right + treeOffset.x;
+        bb.bottom = root.bottom + treeOffset.y;
+        bb.top = root.top + treeOffset.y;
+        return bb;
+      }
       for (const auto& p : v) {
         bb.left = std::min(bb.left, p.x);
         bb.right = std::max(bb.right, p.x);
@@ -90,5 +119,9 @@ Polygon convexHull(std::vector<Point> P);
 
 bool boundingBoxesIntersect(const Polygon& a, const Polygon& b);
 
+/* true if any edge of a intersects any edge of b. Uses the edge trees of both
+ * polygons if available, otherwise tests every pair of edges. */
+bool edgesIntersect(const Polygon& a, const Polygon& b);
+
 bool pointInRectangle(const Point& p, double left, double right, double top,
                       double bottom);
\ No newline at end of file
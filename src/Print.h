@@ -22,7 +22,7 @@
  * SOFTWARE.
  */
 #pragma once
-#include "Problem.h"
+#include "Log.h"
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -37,52 +37,24 @@ template <typename T> std::string toString(T val) {
   return ss.str();
 }
 
-template <typename Head> void print(const Head& h) {
-  if (not problem.silent) {
-    std::cout << h;
-  }
+/* Info messages, written by the logging thread (see Log.h) */
+template <typename... Args> void print(const Args&... args) {
+  if (LogInfo <= CUT_LOG_LEVEL and logEnabled(LogInfo))
+    logger.write(LogInfo, false, args...);
 }
 
-template <typename Head, typename... Tail>
-void print(const Head& h, Tail... tail) {
-  if (not problem.silent) {
-    print(h);
-    print(tail...);
-  }
+template <typename... Args> void println(const Args&... args) {
+  if (LogInfo <= CUT_LOG_LEVEL and logEnabled(LogInfo))
+    logger.write(LogInfo, true, args...);
 }
 
-template <typename Head> void println(const Head& h) {
-  if (not problem.silent) {
-    std::cout << h << std::endl;
-  }
+/* Written whatever the level and silentOutput() */
+template <typename... Args> void printForced(const Args&... args) {
+  logger.write(LogAlways, false, args...);
 }
 
-template <typename Head, typename... Tail>
-void println(const Head& h, Tail... tail) {
-  if (not problem.silent) {
-    print(h);
-    print(tail...);
-    print('\n');
-  }
-}
-
-template <typename Head> void printForced(const Head& h) { std::cout << h; }
-
-template <typename Head, typename... Tail>
-void printForced(const Head& h, Tail... tail) {
-  printForced(h);
-  printForced(tail...);
-}
-
-template <typename Head> void printlnForced(const Head& h) {
-  std::cout << h << std::endl;
-}
-
-template <typename Head, typename... Tail>
-void printlnForced(const Head& h, Tail... tail) {
-  printForced(h);
-  printForced(tail...);
-  printForced('\n');
+template <typename... Args> void printlnForced(const Args&... args) {
+  logger.write(LogAlways, true, args...);
 }
 
 struct comma_numpunct : public std::numpunct<char> {
@@ -22,11 +22,14 @@
  * SOFTWARE.
  */
 #include "Problem.h"
+#include "Memory.h"
 #include "Print.h"
 #include <algorithm>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -34,8 +37,6 @@
 
 using namespace std;
 
-Problem problem;
-
 enum Orientation { Clockwise, CounterClockwise };
 
 Polygon superSample(const Polygon& pol, const int numberOfSamples = 1) {
@@ -54,6 +55,8 @@ Polygon superSample(const Polygon& pol, const int numberOfSamples = 1) {
 }
 
 void Problem::readInstance() {
+  MEMORY_PHASE(IO);
+  SilentScope scope(silent);
   assert(not inputFile.empty());
   if (inputFile.find(".xml") != string::npos) {
     using boost::property_tree::ptree;
@@ -106,7 +109,7 @@ void Problem::readInstance() {
 
     plate = polygons["polygon0"];
   } else {
-    cout << ".txt input file" << endl;
+    println(".txt input file");
 
     ifstream f(inputFile);
     assert(not f.fail());
@@ -136,8 +139,101 @@ void Problem::readInstance() {
     pieceQuantity.clear();
     pieceQuantity.resize(numPieces);
   }
+}
 
-  /* pre-process phase */
+int Problem::addPiece(const Polygon& pol, int quantity,
+                      const vector<double>& angles) {
+  Piece pc(pol);
+  pc.id = pieces.size();
+  for (double angle : angles)
+    pc.angles.push_back(degToRad(angle));
+  pieces.push_back(pc);
+  pieceQuantity.push_back(quantity);
+  return pc.id;
+}
+
+namespace {
+/* Convex hull, counterclockwise. Unlike convexHull(), the orientation
+ * tests are not rounded, so no vertex is left outside. */
+vector<Point> outerHull(vector<Point> p) {
+  sort(p.begin(), p.end(), [](const Point& a, const Point& b) {
+    return a.x < b.x or (a.x == b.x and a.y < b.y);
+  });
+  auto turn = [](const Point& o, const Point& a, const Point& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+  };
+  int n = p.size(), k = 0;
+  vector<Point> h(2 * n);
+  for (int i = 0; i < n; ++i) {
+    while (k >= 2 and turn(h[k - 2], h[k - 1], p[i]) <= 0)
+      --k;
+    h[k++] = p[i];
+  }
+  for (int i = n - 2, t = k + 1; i >= 0; --i) {
+    while (k >= t and turn(h[k - 2], h[k - 1], p[i]) <= 0)
+      --k;
+    h[k++] = p[i];
+  }
+  h.resize(max(1, k - 1));
+  return h;
+}
+
+double distanceToSegment(const Point& p, const Point& a, const Point& b) {
+  Point ab = b - a, ap = p - a;
+  double len2 = ab.x * ab.x + ab.y * ab.y;
+  double t = len2 > 0 ? (ab.x * ap.x + ab.y * ap.y) / len2 : 0;
+  t = min(1.0, max(0.0, t));
+  Point q = a + ab * t;
+  return sqrt((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y));
+}
+
+/* A large disk inside pol: the best point of a grid over its bounding box,
+ * refined by pattern search, with a radius slightly under its distance to
+ * the boundary. Radius 0 if no point was found. */
+void inscribedDisk(const Polygon& pol, Point& center, double& radius) {
+  int n = pol.v.size();
+  auto clearance = [&](const Point& p) {
+    if (not pol.pointInside(p, false)) return 0.0;
+    double d = DBL_MAX;
+    for (int i = 0; i < n; ++i)
+      d = min(d, distanceToSegment(p, pol.v[i], pol.v[(i + 1) % n]));
+    return d;
+  };
+  double left = DBL_MAX, right = -DBL_MAX, bottom = DBL_MAX, top = -DBL_MAX;
+  for (auto& p : pol.v) {
+    left = min(left, p.x), right = max(right, p.x);
+    bottom = min(bottom, p.y), top = max(top, p.y);
+  }
+  const int grid = 32;
+  double dx = (right - left) / grid, dy = (top - bottom) / grid;
+  center = pol.v[0];
+  radius = 0;
+  for (int i = 0; i < grid; ++i) {
+    for (int j = 0; j < grid; ++j) {
+      Point p(left + (i + 0.5) * dx, bottom + (j + 0.5) * dy);
+      double d = clearance(p);
+      if (d > radius) center = p, radius = d;
+    }
+  }
+  for (double step = max(dx, dy) / 2; step > 1e-3 * max(dx, dy); step /= 2) {
+    for (bool moved = true; moved;) {
+      moved = false;
+      for (auto dir : {Point(1, 0), Point(-1, 0), Point(0, 1), Point(0, -1)}) {
+        Point p = center + dir * step;
+        double d = clearance(p);
+        if (d > radius) center = p, radius = d, moved = true;
+      }
+    }
+  }
+  radius *= 1 - 1e-6;
+}
+} // namespace
+
+void Problem::preprocess() {
+  assert(not plate.v.empty() and pieces.size() == pieceQuantity.size());
+  if (preprocessed) return;
+  preprocessed = true;
+  SilentScope scope(silent);
 
   if (plate.v.size() == 4) {
     plateIsRectangle = true;
@@ -174,5 +270,36 @@ void Problem::readInstance() {
     assert(anglesVector.empty());
     for (double i = 0; i <= 360; i += phi)
       anglesVector.push_back(degToRad(i));
+    /* the last angle is 360 degrees when phi divides it */
+    if (anglesVector.size() > 1 and
+        fabs(anglesVector.size() - 1 - 360 / phi) < 1e-6)
+      anglePeriod = anglesVector.size() - 1;
+    if (coarsePhi > phi) coarseStride = lround(coarsePhi / phi);
+  }
+
+  /* the cached values of the plate are computed now, since the search
+   * threads share it */
+  const auto& plateBB = plate.get_bb();
+  plate.area();
+  pieceOrientations.assign(pieces.size(), {});
+  for (auto& pc : pieces) {
+    Point center;
+    double radius;
+    inscribedDisk(pc.pol, center, radius);
+    for (double angle : (phi == 0 ? pc.angles : anglesVector)) {
+      RotatedPiece o;
+      o.pol = pc.pol.rotated(angle);
+      o.pol.buildEdgeTree();
+      o.hull = outerHull(o.pol.v);
+      /* pieces are rotated about the origin */
+      o.innerCenter = center.rotated(angle);
+      o.innerRadius = radius;
+      const auto& bb = o.pol.get_bb();
+      o.fitLeft = plateBB.left - bb.left;
+      o.fitRight = plateBB.right - bb.right;
+      o.fitBottom = plateBB.bottom - bb.bottom;
+      o.fitTop = plateBB.top - bb.top;
+      pieceOrientations[pc.id].push_back(move(o));
+    }
   }
 }
@@ -34,42 +34,122 @@ struct Piece {
   int id = -1;
   Polygon pol;
   std::vector<double> angles;
+
+  /* For a placed piece, if known: pol is pieceOrientations[id][orientation]
+   * translated by pol.treeOffset */
+  int orientation = -1;
+};
+
+/* A piece rotated by one of its allowed angles, with its edge tree built */
+struct RotatedPiece {
+  Polygon pol;
+
+  /* Inner-fit rectangle: translations t for which pol.translated(t) lies
+   * inside the bounding box of the plate. If the plate is a rectangle, these
+   * are exactly the translations that keep the piece inside it. */
+  double fitLeft, fitRight, fitBottom, fitTop;
+
+  bool fits(const Point& t) const {
+    return t.x >= fitLeft - EPS and t.x <= fitRight + EPS and
+           t.y >= fitBottom - EPS and t.y <= fitTop + EPS;
+  }
+
+  /* Conservative approximations in the frame of pol, which decide most
+   * pairs before the exact tests: the convex hull (counterclockwise)
+   * contains the piece, and the disk lies inside it */
+  std::vector<Point> hull;
+  Point innerCenter;
+  double innerRadius;
 };
 
+/* An instance and the options to solve it. The instance can be read from
+ * inputFile, or given in memory by filling plate and adding pieces. The
+ * defaults are those of the command line. */
 struct Problem {
+  /* Reads plate, pieces and pieceQuantity from inputFile */
   void readInstance();
 
+  /* Adds a piece that may be rotated by the given angles (in degrees, used
+   * if phi is 0); returns its id */
+  int addPiece(const Polygon& pol, int quantity,
+               const std::vector<double>& angles = {0});
+
+  /* Derives the data used by the search (rotated pieces, plate bounds, ...)
+   * from the instance and options; called by the Solver */
+  void preprocess();
+  bool preprocessed = false;
+
   std::vector<Piece> pieces;
   std::vector<int> pieceQuantity;
 
   std::vector<double> anglesVector;
   double phi = 0;
 
-  bool randomAlgorithm;
-  std::string optimizeString;
+  /* Coarse-to-fine rotation search, for phi != 0: orientations are first
+   * tried every coarsePhi degrees, then at half the step, repeatedly down to
+   * phi, around the refineAngles best ones so far. 0 tries them all. */
+  double coarsePhi = 0;
+  int refineAngles = 3;
+  int coarseStride = 1; /* coarsePhi in orientations, set by preprocess() */
+  int anglePeriod = 0; /* orientations in a full turn, 0 if it does not close */
+
+  /* pieceOrientations[id][a] is piece id rotated by its a-th allowed angle
+   * (anglesVector, or the piece's own angles if phi is 0) */
+  std::vector<std::vector<RotatedPiece>> pieceOrientations;
+
+  bool randomAlgorithm = false;
+  std::string optimizeString = "length,width,compaction";
   int orientation;
   Polygon plate;
   int m = 1;
   bool plateIsRectangle = false;
   double plateLeft, plateRight, plateTop, plateBottom;
-  std::string inputFile, outputFile;
+  std::string inputFile, outputFile, traceFile, memoryFile;
+  std::string initFile; /* layout to start from */
+  std::string svgFile, pdfFile;
+
+  /* checkpoints of the iterated greedy: written to checkpointFile every
+   * checkpointSeconds, and read from resumeFile to continue a run */
+  std::string checkpointFile, resumeFile;
+  double checkpointSeconds = 300.0;
   int randomSeed = 0;
   int piecesSuperSample = 0, plateSuperSample = 5;
-  bool optimizeCompaction = false, optimizeLength = true, optimizeWidth = false;
-  bool infinitePolygons = false;
+  bool optimizeCompaction = true, optimizeLength = true, optimizeWidth = true;
+  bool infinitePolygons = true;
   bool useBB = true;
   bool silent = false;
-  bool iteratedGreedy = false;
-  bool alphaGreedy = false;
-  double alpha = 0.2;
-  double areaPercentToDeconstruct = 30.0;
+  bool iteratedGreedy = true;
+  bool alphaGreedy = true;
+  double alpha = 0.01;
+  double areaPercentToDeconstruct = 0.4;
+
+  /* copies of the plate; 0 uses as many as needed */
+  int numSheets = 1;
+
+  /* only accept layouts that hold every available piece (set for sheets) */
+  bool keepAllPieces = false;
+
+  /* threads of the parallel iterated greedy */
+  int numThreads = 1;
+
+  /* island model */
+  int numIslands = 1, islandId = 0;
+  std::string islandSocket;
+  double migrationSeconds = 10.0;
 
   bool timeLimitExceeded() const {
     return timerSeconds(timer) >= timeLimitSeconds;
   }
 
   int timeLimitSeconds = 600;
+
+  /* stop after this many work units (see Statistics::work); 0: no limit */
+  int64_t workBudget = 0;
+
+  /* early stopping: utilization to reach, in percent, and iterations or
+   * seconds without improvement; 0: not used */
+  double targetUtilization = 0;
+  int64_t stagnationIterations = 0;
+  double stagnationSeconds = 0;
   Timer<> timer;
 };
-
-extern Problem problem;
\ No newline at end of file
@@ -22,26 +22,60 @@
  * SOFTWARE.
  */
 #pragma once
-#include <random>
+#include <cstdint>
+#include <limits>
 
+/* Counter-based random number generator. The i-th number of a stream is a
+ * hash of the stream's key and i, so streams derived from one seed are
+ * independent, cost nothing to create, and produce the same numbers no
+ * matter which thread draws them or when. */
 struct RNG {
-  std::mt19937 engine;
+  typedef uint64_t result_type;
 
-  void seed(int seed) { engine.seed(seed); }
+  RNG() {}
+
+  void seed(uint64_t seed) {
+    key = mix(seed);
+    counter = 0;
+  }
+
+  /* Stream number s derived from this one, e.g. one per worker or task */
+  RNG stream(uint64_t s) const {
+    RNG r;
+    r.key = mix(key ^ mix(s + 1));
+    return r;
+  }
+
+  result_type operator()() {
+    return mix(key + 0x9E3779B97F4A7C15ULL * ++counter);
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
 
   double randomDouble(double from, double to) {
-    static std::uniform_real_distribution<double> d;
-    return d(engine, decltype(d)::param_type{from, to});
+    return from + (to - from) * ((*this)() >> 11) * (1.0 / (1ULL << 53));
   }
 
+  /* uniform in [from, to] */
   int randomInt(int from, int to) {
-    static std::uniform_int_distribution<int> d;
-    return d(engine, decltype(d)::param_type{from, to});
+    uint64_t range = uint64_t(int64_t(to) - from) + 1;
+    return from + int((((*this)() >> 32) * range) >> 32);
   }
 
   bool reservoirSampling(int candidateNumber) {
     return randomDouble(0, 1) < (1.0 / double(candidateNumber));
   }
-};
 
-extern RNG rng;
\ No newline at end of file
+  uint64_t key = 0, counter = 0;
+
+private:
+  /* splitmix64 finalizer */
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+};
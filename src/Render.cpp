@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Render.h"
+#include "Memory.h"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+
+using namespace std;
+
+namespace {
+struct Color {
+  double r, g, b;
+};
+
+/* Well-separated hues for consecutive types (golden ratio steps) */
+Color typeColor(int type) {
+  double h = fmod(type * 0.618033988749895, 1.0) * 6;
+  double s = 0.45, v = 0.95;
+  double f = h - floor(h), p = v * (1 - s), q = v * (1 - s * f),
+         t = v * (1 - s * (1 - f));
+  switch ((int)h) {
+  case 0: return {v, t, p};
+  case 1: return {q, v, p};
+  case 2: return {p, v, t};
+  case 3: return {p, q, v};
+  case 4: return {t, p, v};
+  default: return {v, p, q};
+  }
+}
+
+const Color plateColor = {0.83, 0.83, 0.83};
+
+/* appends printf-style output to s */
+template <typename... Args>
+void append(string& s, const char* format, Args... args) {
+  char buf[128];
+  int n = snprintf(buf, sizeof(buf), format, args...);
+  if (n < 0) return;
+  if (n < (int)sizeof(buf)) {
+    s.append(buf, n);
+    return;
+  }
+  /* truncated: format again, straight into s */
+  size_t end = s.size();
+  s.resize(end + n + 1);
+  snprintf(&s[end], n + 1, format, args...);
+  s.resize(end + n);
+}
+
+void writeFile(const string& file, const string& contents) {
+  FILE* f = fopen(file.c_str(), "wb");
+  assert(f != nullptr);
+  fwrite(contents.data(), 1, contents.size(), f);
+  fclose(f);
+}
+
+Drawing readDrawing(istream& f) {
+  Drawing d;
+  int n;
+  f >> n;
+  d.plate.v.resize(n);
+  for (auto& p : d.plate.v)
+    f >> p.x >> p.y;
+  f >> n;
+  d.pieces.resize(n);
+  for (auto& pol : d.pieces) {
+    f >> n;
+    pol.v.resize(n);
+    for (auto& p : pol.v)
+      f >> p.x >> p.y;
+    long long area = llround(pol.area() * 1e6 / d.plate.area());
+    d.types.push_back(int(area % 100003) * 31 + pol.v.size());
+  }
+  return d;
+}
+} // namespace
+
+Drawing Drawing::read(const string& file) {
+  return readSheets(file)[0];
+}
+
+vector<Drawing> Drawing::readSheets(const string& file) {
+  ifstream f(file);
+  assert(not f.fail());
+  string word;
+  f >> word;
+  if (word != "sheets") {
+    f.seekg(0);
+    return {readDrawing(f)};
+  }
+  int n;
+  f >> n;
+  vector<Drawing> sheets;
+  for (int k = 0; k < n; ++k) {
+    f >> word >> word; /* sheet k */
+    sheets.push_back(readDrawing(f));
+  }
+  return sheets;
+}
+
+string sheetFileName(const string& file, int sheet) {
+  size_t dot = file.rfind('.');
+  if (dot == string::npos or file.find('/', dot) != string::npos)
+    dot = file.size();
+  return file.substr(0, dot) + "." + to_string(sheet) + file.substr(dot);
+}
+
+void Drawing::writeSvg(const string& file) const {
+  MEMORY_PHASE(IO);
+  auto& bb = const_cast<Polygon&>(plate).get_bb();
+  double w = bb.right - bb.left, h = bb.top - bb.bottom;
+  double margin = 0.01 * max(w, h);
+
+  string s;
+  s.reserve(64 + 24 * plate.v.size() + 96 * pieces.size());
+  append(s, "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+            "viewBox=\"%g %g %g %g\">\n",
+         bb.left - margin, -bb.top - margin, w + 2 * margin, h + 2 * margin);
+  /* y grows downwards in SVG */
+  s += "<g transform=\"scale(1,-1)\" stroke=\"black\" "
+       "stroke-linejoin=\"round\" stroke-width=\"1\">\n";
+
+  auto polygon = [&](const Polygon& pol, const Color& c) {
+    append(s, "<polygon fill=\"#%02x%02x%02x\" points=\"", int(c.r * 255),
+           int(c.g * 255), int(c.b * 255));
+    for (auto& p : pol.v)
+      append(s, "%g,%g ", p.x, p.y);
+    s.back() = '"';
+    s += " vector-effect=\"non-scaling-stroke\"/>\n";
+  };
+  polygon(plate, plateColor);
+  for (int i = 0; i < (int)pieces.size(); ++i)
+    polygon(pieces[i], typeColor(types[i]));
+
+  s += "</g>\n</svg>\n";
+  writeFile(file, s);
+}
+
+void Drawing::writePdf(const string& file) const {
+  MEMORY_PHASE(IO);
+  /* fit the longer side of the plate in 800 points */
+  auto& bb = const_cast<Polygon&>(plate).get_bb();
+  double w = bb.right - bb.left, h = bb.top - bb.bottom;
+  double scale = 800 / max(w, h), margin = 10;
+
+  string content;
+  content += "0.5 w 1 j\n";
+  auto polygon = [&](const Polygon& pol, const Color& c) {
+    append(content, "%.3f %.3f %.3f rg\n", c.r, c.g, c.b);
+    for (int i = 0; i < (int)pol.v.size(); ++i) {
+      append(content, "%.2f %.2f %c\n",
+             margin + (pol.v[i].x - bb.left) * scale,
+             margin + (pol.v[i].y - bb.bottom) * scale, i == 0 ? 'm' : 'l');
+    }
+    content += "b\n"; /* close, fill and stroke */
+  };
+  polygon(plate, plateColor);
+  for (int i = 0; i < (int)pieces.size(); ++i)
+    polygon(pieces[i], typeColor(types[i]));
+
+  /* objects: 1 catalog, 2 page tree, 3 page, 4 content stream */
+  string s = "%PDF-1.4\n";
+  vector<size_t> offsets;
+  auto object = [&](const string& body) {
+    offsets.push_back(s.size());
+    append(s, "%d 0 obj\n", (int)offsets.size());
+    s += body;
+    s += "\nendobj\n";
+  };
+  object("<< /Type /Catalog /Pages 2 0 R >>");
+  object("<< /Type /Pages /Kids [3 0 R] /Count 1 >>");
+  string page;
+  append(page,
+         "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] "
+         "/Contents 4 0 R >>",
+         w * scale + 2 * margin, h * scale + 2 * margin);
+  object(page);
+  string stream;
+  append(stream, "<< /Length %d >>\nstream\n", (int)content.size());
+  object(stream + content + "endstream");
+
+  size_t xref = s.size();
+  append(s, "xref\n0 %d\n0000000000 65535 f \n", (int)offsets.size() + 1);
+  for (size_t o : offsets)
+    append(s, "%010d 00000 n \n", (int)o);
+  append(s, "trailer\n<< /Size %d /Root 1 0 R >>\nstartxref\n%d\n%%%%EOF\n",
+         (int)offsets.size() + 1, (int)xref);
+  writeFile(file, s);
+}
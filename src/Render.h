@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include "Polygon.h"
+#include <string>
+#include <vector>
+
+/* A layout to be drawn. Pieces with the same type get the same color. */
+struct Drawing {
+  Polygon plate;
+  std::vector<Polygon> pieces;
+  std::vector<int> types;
+
+  /* Reads a layout in the format of Algorithm::writeOutput. The file does
+   * not name the pieces, so pieces are typed by their number of vertices
+   * and area. */
+  static Drawing read(const std::string& file);
+
+  /* One drawing per sheet of a multi-sheet output (see
+   * Solver::writeOutput), or just one for a plain layout */
+  static std::vector<Drawing> readSheets(const std::string& file);
+
+  void writeSvg(const std::string& file) const;
+
+  /* Single-page PDF, with no compression or fonts */
+  void writePdf(const std::string& file) const;
+};
+
+/* 'file' with ".k" inserted before its extension: the file of sheet k */
+std::string sheetFileName(const std::string& file, int sheet);
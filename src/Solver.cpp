@@ -0,0 +1,249 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Solver.h"
+#include "Island.h"
+#include "Memory.h"
+#include "Print.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+/* copies of each piece on the layout */
+vector<int> placedCounts(const Algorithm& alg) {
+  vector<int> placed(alg.problem.pieces.size(), 0);
+  for (int i = 1; i < (int)alg.fixed.size(); ++i)
+    if (alg.fixed[i].id >= 0) ++placed[alg.fixed[i].id];
+  return placed;
+}
+
+int total(const vector<int>& quantity) {
+  return accumulate(quantity.begin(), quantity.end(), 0);
+}
+} // namespace
+
+Solver::Solver(Problem p) : problem(move(p)), alg(problem, statistics) {
+  problem.preprocess();
+}
+
+vector<Polygon> Solver::solve() {
+  silentOutput() = problem.silent;
+  /* keep the seed actually used, so that the run can be reproduced */
+  if (problem.randomSeed == 0) problem.randomSeed = time(NULL);
+  statistics = Statistics();
+  if (problem.numIslands > 1)
+    islands.start(problem.islandSocket, problem.numIslands, problem.islandId);
+  problem.timer.restart();
+  if (problem.numSheets != 1) return solveSheets();
+  alg.run();
+  return alg.layoutPolygons();
+}
+
+vector<Polygon> Solver::solveSheets() {
+  /* Which pieces go on each sheet is decided by constructive fills, one
+   * sheet after the other, each with the pieces left by the previous ones */
+  sheets.clear();
+  unplaced = problem.pieceQuantity;
+  alg.seedRandom();
+  while (total(unplaced) > 0 and not alg.stopRequested() and
+         (problem.numSheets == 0 or (int)sheets.size() < problem.numSheets)) {
+    auto sheet = newSheet(unplaced);
+    sheet->alg.prepare();
+    /* as the workers of a parallel search, each sheet draws from its own
+     * stream of the run's generator */
+    sheet->alg.rng = alg.rng.stream(sheets.size() + 1);
+    sheet->alg.constructiveGreedy();
+    sheet->alg.commitLayout();
+    vector<int> placed = placedCounts(sheet->alg);
+    /* the pieces left fit on no sheet */
+    if (total(placed) == 0) break;
+    for (int i = 0; i < (int)placed.size(); ++i)
+      unplaced[i] -= placed[i];
+    sheet->problem.pieceQuantity = placed;
+    sheets.push_back(move(sheet));
+    println("sheet ", sheets.size() - 1, ": ", total(placed), " pieces, ",
+            total(unplaced), " left");
+  }
+
+  /* The sheets are then improved at once, a thread each. Sheets keep all
+   * their pieces, so the search compacts them. The work budget left is
+   * split evenly. */
+  if (problem.workBudget > 0 and not sheets.empty()) {
+    int64_t used = 0;
+    for (auto& sheet : sheets)
+      used += sheet->statistics.work();
+    int64_t share = max<int64_t>(1, (problem.workBudget - used) /
+                                        (int64_t)sheets.size());
+    for (auto& sheet : sheets)
+      sheet->alg.workBudget = sheet->statistics.work() + share;
+  }
+  vector<future<void>> running;
+  for (int k = 0; k < (int)sheets.size(); ++k) {
+    Solver* s = sheets[k].get();
+    running.push_back(async(launch::async, [s, k] {
+      silentOutput() = true;
+      setLogTag("sheet " + toString(k));
+      s->alg.search();
+    }));
+  }
+  for (auto& r : running) {
+    while (r.wait_for(chrono::milliseconds(10)) != future_status::ready) {
+      if (alg.cancelled)
+        for (auto& sheet : sheets)
+          sheet->cancel();
+    }
+    r.get();
+  }
+
+  /* Compaction frees space: fill it with the pieces that fit nowhere, and
+   * then try to move the pieces of the last sheet to the others */
+  for (int k = 0; k < (int)sheets.size(); ++k) {
+    fillSheet(k, unplaced);
+    sheets[k]->alg.commitLayout();
+  }
+  while (sheets.size() > 1) {
+    vector<int> pool = sheets.back()->problem.pieceQuantity;
+    int n = sheets.size() - 1;
+    for (int k = 0; k < n; ++k)
+      fillSheet(k, pool);
+    bool emptied = total(pool) == 0;
+    for (int k = 0; k < n; ++k) {
+      auto& a = sheets[k]->alg;
+      if (emptied) {
+        a.commitLayout();
+      } else {
+        a.rollbackLayout();
+        sheets[k]->problem.pieceQuantity = placedCounts(a);
+      }
+    }
+    if (not emptied) break;
+    sheets.pop_back();
+    println("moved the pieces of sheet ", n, " to the other sheets");
+  }
+
+  statistics = Statistics();
+  vector<Polygon> layout;
+  for (auto& sheet : sheets) {
+    statistics.add(sheet->statistics);
+    for (auto& pol : sheet->alg.layoutPolygons())
+      layout.push_back(pol);
+  }
+  return layout;
+}
+
+unique_ptr<Solver> Solver::newSheet(const vector<int>& quantity) const {
+  Problem p = problem;
+  p.numSheets = 1;
+  p.pieceQuantity = quantity;
+  p.infinitePolygons = false;
+  p.keepAllPieces = true;
+  p.numThreads = 1;
+  p.numIslands = 1;
+  p.initFile.clear();
+  p.checkpointFile.clear();
+  p.resumeFile.clear();
+  return unique_ptr<Solver>(new Solver(move(p)));
+}
+
+void Solver::fillSheet(int k, vector<int>& pool) {
+  Solver& sheet = *sheets[k];
+  vector<int> placed = placedCounts(sheet.alg);
+  for (int i = 0; i < (int)pool.size(); ++i)
+    sheet.problem.pieceQuantity[i] = placed[i] + pool[i];
+  sheet.alg.commitLayout();
+  sheet.alg.constructiveGreedy();
+  vector<int> filled = placedCounts(sheet.alg);
+  for (int i = 0; i < (int)pool.size(); ++i)
+    pool[i] -= filled[i] - placed[i];
+  sheet.problem.pieceQuantity = filled;
+}
+
+future<vector<Polygon>> Solver::solveAsync() {
+  return async(launch::async, [this] { return solve(); });
+}
+
+void Solver::onImprovement(ImprovementCallback callback) {
+  if (not callback) {
+    alg.onImprovement = nullptr;
+    return;
+  }
+  alg.onImprovement = [callback](const Algorithm& a) {
+    callback(a.layoutPolygons(), 100.0 * a.fixedArea / a.problem.plate.area());
+  };
+}
+
+double Solver::utilization() const {
+  if (problem.numSheets == 1 or sheets.empty())
+    return 100.0 * alg.fixedArea / problem.plate.area();
+  double area = 0;
+  for (auto& sheet : sheets)
+    area += sheet->alg.fixedArea;
+  return 100.0 * area / (sheets.size() * problem.plate.area());
+}
+
+void Solver::writeOutput() const {
+  MEMORY_PHASE(IO);
+  ofstream f(problem.outputFile);
+  assert(not f.fail());
+  if (problem.numSheets == 1) {
+    alg.writeLayout(f);
+    return;
+  }
+  f << "sheets " << sheets.size() << endl;
+  for (int k = 0; k < (int)sheets.size(); ++k) {
+    f << "sheet " << k << endl;
+    sheets[k]->alg.writeLayout(f);
+  }
+}
+
+vector<Drawing> Solver::drawings() const {
+  if (problem.numSheets == 1) return {alg.drawing()};
+  vector<Drawing> d;
+  for (auto& sheet : sheets)
+    d.push_back(sheet->alg.drawing());
+  return d;
+}
+
+void Solver::printStatistics() const {
+  if (problem.numSheets == 1) {
+    statistics.printFinalStatistics(problem, alg);
+  } else {
+    for (int k = 0; k < (int)sheets.size(); ++k) {
+      println("--statistic sheet ", k);
+      sheets[k]->statistics.printFinalStatistics(sheets[k]->problem,
+                                                 sheets[k]->alg);
+    }
+    println("--statistic sheets ", sheets.size());
+    println("--statistic unplaced-pieces ", total(unplaced));
+    println("--statistic total-iterations ", statistics.iterations);
+    println("--statistic total-work ", statistics.work());
+    println("--statistic value ", utilization());
+  }
+  if (problem.silent) printForced(-utilization());
+}
@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include "Algorithm.h"
+#include "Problem.h"
+#include "Statistics.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+/* Entry point of the solver library. A Solver owns its problem, search state
+ * and statistics, so several solvers can run in one process at once. The
+ * island model and the tracer are still shared by the whole process. */
+struct Solver {
+  /* called on the solving thread with each new incumbent layout and its
+   * utilization of the plate, in percent */
+  typedef std::function<void(const std::vector<Polygon>& layout,
+                             double utilization)>
+      ImprovementCallback;
+
+  /* 'problem' holds the instance, read with readInstance() or built in
+   * memory, and the options */
+  explicit Solver(Problem problem);
+
+  Solver(const Solver&) = delete;
+  Solver& operator=(const Solver&) = delete;
+
+  /* Runs until the time limit or cancel(); returns the placed pieces, those
+   * of all sheets one after the other with problem.numSheets != 1 */
+  std::vector<Polygon> solve();
+
+  /* Runs solve() on a new thread. The solver must outlive the future. */
+  std::future<std::vector<Polygon>> solveAsync();
+
+  /* Stops a running solve() soon, keeping the best layout found; safe to
+   * call from any thread. A cancelled solver stays cancelled. */
+  void cancel() { alg.cancelled = true; }
+
+  /* Not called for the sheets of a multi-sheet run */
+  void onImprovement(ImprovementCallback callback);
+
+  /* utilization of the plate by the current layout, in percent; the
+   * average over the used sheets in a multi-sheet run */
+  double utilization() const;
+
+  /* The format of Algorithm::writeOutput, to problem.outputFile. A
+   * multi-sheet run writes "sheets N", then "sheet k" and the layout of
+   * sheet k for each sheet. */
+  void writeOutput() const;
+
+  /* a drawing of each sheet */
+  std::vector<Drawing> drawings() const;
+
+  void printStatistics() const;
+
+  Problem problem;
+  Statistics statistics;
+  Algorithm alg;
+
+  /* Multi-sheet runs: a solver for each used sheet, holding just the pieces
+   * placed on it, and the copies of each piece that fit on no sheet */
+  std::vector<std::unique_ptr<Solver>> sheets;
+  std::vector<int> unplaced;
+
+private:
+  std::vector<Polygon> solveSheets();
+
+  /* A solver for another sheet with the given pieces on it */
+  std::unique_ptr<Solver> newSheet(const std::vector<int>& quantity) const;
+
+  /* Adds copies from 'pool' to the free space of sheet k, removing them
+   * from the pool; the addition is committed, so it can be rolled back */
+  void fillSheet(int k, std::vector<int>& pool);
+};
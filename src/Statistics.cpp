@@ -23,6 +23,7 @@
  */
 #include "Statistics.h"
 #include "Algorithm.h"
+#include "Island.h"
 #include "Print.h"
 #include "Problem.h"
 #include <algorithm>
@@ -34,9 +35,8 @@
 
 using namespace std;
 
-Statistics statistics;
-
-void Statistics::printFinalStatistics() {
+void Statistics::printFinalStatistics(const Problem& problem,
+                                      const Algorithm& alg) const {
   double minX = DBL_MAX, maxX = -DBL_MAX, minY = DBL_MAX, maxY = -DBL_MAX;
 
   for (int i = 1; i < (int)alg.fixed.size(); ++i) {
@@ -95,9 +95,32 @@ void Statistics::printFinalStatistics() {
 
   println("--statistic bb-tests ", numBBTests);
   println("--statistic bb-tests-succeeded ", numBBTestsSucceeded);
+  println("--statistic pair-tests ", numPairTests);
+  println("--statistic pair-memo-hits ", numPairMemoHits);
+  println("--statistic duplicate-positions ", numDuplicatePositions);
+  println("--statistic approx-accepts ", numApproxAccepts);
+  println("--statistic approx-rejects ", numApproxRejects);
   println("--statistic time ", timerSeconds(problem.timer));
+  println("--statistic work ", work());
+  println("--statistic work-per-second ",
+          work() / max(timerSeconds(problem.timer), 1e-9));
   println("--statistic iterations ", iterations);
+  println("--statistic stop-reason ", alg.stopReason());
+  if (islands.numIslands > 1 or problem.numIslands > 1) {
+    println("--statistic island ", islands.id);
+    println("--statistic migrations-sent ", islands.migrationsSent);
+    println("--statistic migrations-received ", islands.migrationsReceived);
+  }
+}
 
-  if (problem.silent)
-    printForced(-100.0 * alg.fixedArea / problem.plate.area());
+void Statistics::add(const Statistics& other) {
+  iterations += other.iterations;
+  numFeasabilityTests += other.numFeasabilityTests;
+  numBBTests += other.numBBTests;
+  numBBTestsSucceeded += other.numBBTestsSucceeded;
+  numPairTests += other.numPairTests;
+  numPairMemoHits += other.numPairMemoHits;
+  numDuplicatePositions += other.numDuplicatePositions;
+  numApproxAccepts += other.numApproxAccepts;
+  numApproxRejects += other.numApproxRejects;
 }
@@ -24,14 +24,27 @@
 #pragma once
 #include <cstdint>
 
+struct Algorithm;
+struct Problem;
+
 struct Statistics {
 
-  void printFinalStatistics();
+  void printFinalStatistics(const Problem& problem,
+                            const Algorithm& alg) const;
+
+  /* Deterministic measure of the effort spent: one unit per feasibility
+   * test, which all cost about the same. Unlike time, it does not depend on
+   * the machine or its load. */
+  int64_t work() const { return numFeasabilityTests; }
+
+  /* adds the counters of another search (a worker thread or a sheet) */
+  void add(const Statistics& other);
 
   double v0 = 0;
   int64_t iterations = 0;
   int64_t numFeasabilityTests = 0;
   int64_t numBBTests = 0, numBBTestsSucceeded = 0;
-};
-
-extern Statistics statistics;
\ No newline at end of file
+  int64_t numPairTests = 0, numPairMemoHits = 0;
+  int64_t numDuplicatePositions = 0;
+  int64_t numApproxAccepts = 0, numApproxRejects = 0;
+};
\ No newline at end of file
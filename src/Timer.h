@@ -33,6 +33,13 @@ public:
 
   void restart() { t = Clock::now(); }
 
+  /* restarts as if 'seconds' had already elapsed */
+  void restart(double seconds) {
+    t = Clock::now() -
+        std::chrono::duration_cast<typename Clock::duration>(
+            std::chrono::duration<double>(seconds));
+  }
+
   template <typename R = std::milli, typename T = double> T elapsed() const {
     return std::chrono::duration_cast<std::chrono::duration<T, R>>(
                Clock::now() - t)
@@ -0,0 +1,74 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Trace.h"
+#include "Print.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+
+Tracer tracer;
+
+void Tracer::open(const string& file) {
+  this->file = file;
+  start = chrono::steady_clock::now();
+  enabled = true;
+}
+
+Tracer::Buffer& Tracer::threadBuffer() {
+  thread_local Buffer* buffer = nullptr;
+  if (buffer == nullptr) {
+    lock_guard<std::mutex> lock(mutex);
+    buffers.emplace_back(new Buffer(buffers.size()));
+    buffer = buffers.back().get();
+  }
+  return *buffer;
+}
+
+void Tracer::write() {
+  if (not enabled) return;
+  lock_guard<std::mutex> lock(mutex);
+  ofstream f(file);
+  if (f.fail()) {
+    printlnForced("could not write trace to ", file);
+    return;
+  }
+  f << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (auto& b : buffers) {
+    uint64_t n = min<uint64_t>(b->count, Buffer::capacity);
+    for (uint64_t i = b->count - n; i < b->count; ++i) {
+      const Event& e = b->events[i % Buffer::capacity];
+      f << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\""
+        << e.phase << "\",\"ts\":" << e.ts << ",\"pid\":0,\"tid\":" << b->tid;
+      if (e.phase == 'X') {
+        f << ",\"dur\":" << e.dur << "}";
+      } else {
+        f << ",\"args\":{\"value\":" << e.value << "}}";
+      }
+      first = false;
+    }
+  }
+  f << "\n]}\n";
+}
@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Timeline of the solver in Chrome trace-event format, viewable in
+ * chrome://tracing or Perfetto. Each thread records its events into its own
+ * ring buffer, which keeps the newest events; they are only formatted by
+ * write(). When tracing is disabled, recording costs one branch. */
+struct Tracer {
+  struct Event {
+    const char* name; /* must be a string literal */
+    char phase;       /* 'X': complete event, 'C': counter */
+    int64_t ts, dur;  /* microseconds */
+    double value;
+  };
+
+  struct Buffer {
+    explicit Buffer(int tid) : tid(tid), events(capacity) {}
+    static const size_t capacity = 1 << 18;
+    int tid;
+    std::vector<Event> events;
+    uint64_t count = 0; /* events recorded; the last 'capacity' are kept */
+  };
+
+  void open(const std::string& file);
+
+  void write();
+
+  int64_t now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  void record(const Event& e) {
+    Buffer& b = threadBuffer();
+    b.events[b.count++ % Buffer::capacity] = e;
+  }
+
+  void counter(const char* name, double value) {
+    if (enabled) record({name, 'C', now(), 0, value});
+  }
+
+  bool enabled = false;
+
+private:
+  Buffer& threadBuffer();
+
+  std::string file;
+  std::chrono::steady_clock::time_point start;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+extern Tracer tracer;
+
+/* Records the lifetime of the enclosing scope as one event */
+struct TraceScope {
+  explicit TraceScope(const char* name) : name(name) {
+    if (tracer.enabled) ts = tracer.now();
+  }
+  ~TraceScope() {
+    if (tracer.enabled) tracer.record({name, 'X', ts, tracer.now() - ts, 0});
+  }
+  const char* name;
+  int64_t ts = 0;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
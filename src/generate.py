@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# Generates synthetic instances in the .txt and .xml formats read by
+# Problem::readInstance, for scaling benchmarks. The output only depends on
+# the arguments (including --seed).
+#
+# Examples:
+#   python3 generate.py --pieces 1000 --seed 1 big.xml
+#   python3 generate.py --pieces 50 --vertices 100 200 --nonconvex 1 big.txt
+import argparse, math, random, sys
+
+def polygonArea(v):
+	return 0.5 * sum(v[i - 1][0] * v[i][1] - v[i][0] * v[i - 1][1]
+	                 for i in range(len(v)))
+
+def randomPiece(rnd, n, convex, area, maxAspect):
+	# Vertices at increasing angles around the origin, one in each of n equal
+	# sectors: on an ellipse (convex), or at random radii (star-shaped, in
+	# general non-convex). Counterclockwise.
+	angles = [(i + rnd.uniform(0.1, 0.9)) * 2 * math.pi / n for i in range(n)]
+	aspect = rnd.uniform(1, maxAspect)
+	v = []
+	for a in angles:
+		r = 1.0 if convex else rnd.uniform(0.35, 1.0)
+		v.append((r * math.cos(a) * aspect, r * math.sin(a)))
+	s = math.sqrt(area / polygonArea(v))
+	x0 = min(p[0] for p in v)
+	y0 = min(p[1] for p in v)
+	return [((x - x0) * s, (y - y0) * s) for x, y in v]
+
+def pieceAreas(rnd, args):
+	if args.areas == 'equal':
+		return [1.0] * args.pieces
+	if args.areas == 'uniform':
+		return [rnd.uniform(1, args.spread) for i in range(args.pieces)]
+	# lognormal, clipped so that the largest piece is at most 'spread' times
+	# the smallest one
+	a = [rnd.lognormvariate(0, 1) for i in range(args.pieces)]
+	lo = min(a)
+	return [min(x / lo, args.spread) for x in a]
+
+def plateShape(args, area):
+	# area of the bounding box
+	area /= {'rectangle': 1, 'lshape': 0.75, 'ellipse': math.pi / 4}[args.plate]
+	h = math.sqrt(area / args.aspect) if args.height == 0 else args.height
+	w = area / h if args.width == 0 else args.width
+	if args.plate == 'rectangle':
+		return [(0, 0), (w, 0), (w, h), (0, h)]
+	if args.plate == 'lshape':
+		return [(0, 0), (w, 0), (w, h / 2), (w / 2, h / 2), (w / 2, h), (0, h)]
+	# ellipse inscribed in the w x h box
+	n = 64
+	return [(w / 2 + w / 2 * math.cos(2 * math.pi * i / n),
+	         h / 2 + h / 2 * math.sin(2 * math.pi * i / n)) for i in range(n)]
+
+def fmt(x):
+	return ('%.4f' % x).rstrip('0').rstrip('.')
+
+def writeTxt(f, plate, pieces):
+	f.write('%d\n' % len(plate))
+	for x, y in plate:
+		f.write('%s %s\n' % (fmt(x), fmt(y)))
+	f.write('%d\n' % len(pieces))
+	for v in pieces:
+		f.write('%d\n' % len(v))
+		for x, y in v:
+			f.write('%s %s\n' % (fmt(x), fmt(y)))
+
+def writeXml(f, plate, pieces, quantities, angles):
+	f.write('<?xml version="1.0" encoding="UTF-8"?>\n<nesting>\n')
+	f.write('  <name>synthetic</name>\n')
+	f.write('  <verticesOrientation>counterclockwise</verticesOrientation>\n')
+	f.write('  <problem>\n    <boards>\n')
+	f.write('      <piece id="board0" quantity="1">\n')
+	f.write('        <component idPolygon="polygon0" type="0"/>\n')
+	f.write('      </piece>\n    </boards>\n    <lot>\n')
+	for i, q in enumerate(quantities):
+		f.write('      <piece id="piece%d" quantity="%d">\n' % (i, q))
+		f.write('        <orientation>\n')
+		for a in angles:
+			f.write('          <enumeration angle="%s"/>\n' % fmt(a))
+		f.write('        </orientation>\n')
+		f.write('        <component idPolygon="polygon%d" type="0"/>\n' % (i + 1))
+		f.write('      </piece>\n')
+	f.write('    </lot>\n  </problem>\n  <polygons>\n')
+	for i, v in enumerate([plate] + pieces):
+		f.write('    <polygon id="polygon%d" nVertices="%d">\n' % (i, len(v)))
+		f.write('      <lines>\n')
+		for j in range(len(v)):
+			(x0, y0), (x1, y1) = v[j], v[(j + 1) % len(v)]
+			f.write('        <segment n="%d" x0="%s" y0="%s" x1="%s" y1="%s"/>\n'
+			        % (j + 1, fmt(x0), fmt(y0), fmt(x1), fmt(y1)))
+		f.write('      </lines>\n    </polygon>\n')
+	f.write('  </polygons>\n</nesting>\n')
+
+def main():
+	p = argparse.ArgumentParser(description='Generates a synthetic nesting '
+	    'instance. The format (.txt or .xml) is given by the output file name.')
+	p.add_argument('output')
+	p.add_argument('--seed', type=int, default=1)
+	p.add_argument('--pieces', type=int, default=20,
+	               help='number of distinct pieces')
+	p.add_argument('--vertices', type=int, nargs=2, default=[4, 12],
+	               metavar=('MIN', 'MAX'), help='vertices per piece')
+	p.add_argument('--nonconvex', type=float, default=0.5,
+	               help='fraction of non-convex pieces')
+	p.add_argument('--areas', choices=['equal', 'uniform', 'lognormal'],
+	               default='lognormal', help='distribution of piece areas')
+	p.add_argument('--spread', type=float, default=10,
+	               help='largest to smallest piece area ratio')
+	p.add_argument('--elongation', type=float, default=3,
+	               help='maximum aspect ratio of a piece')
+	p.add_argument('--quantities', type=int, nargs=2, default=[1, 5],
+	               metavar=('MIN', 'MAX'),
+	               help='copies of each piece (xml only; txt instances have '
+	               'unlimited copies)')
+	p.add_argument('--angles', type=float, nargs='+', default=[0, 90, 180, 270],
+	               help='allowed rotations in degrees (xml only)')
+	p.add_argument('--plate', choices=['rectangle', 'lshape', 'ellipse'],
+	               default='rectangle')
+	p.add_argument('--fill', type=float, default=0.8,
+	               help='total piece area over plate area, used to size the '
+	               'plate when --width/--height are not given')
+	p.add_argument('--aspect', type=float, default=2,
+	               help='plate width over height, when sizing the plate')
+	p.add_argument('--width', type=float, default=0)
+	p.add_argument('--height', type=float, default=0)
+	p.add_argument('--scale', type=float, default=100,
+	               help='side of a square with the area of the smallest piece')
+	args = p.parse_args()
+	if not args.output.endswith(('.txt', '.xml')):
+		sys.exit('output file must end in .txt or .xml')
+	if args.vertices[0] < 3 or args.vertices[1] < args.vertices[0]:
+		sys.exit('invalid vertex range')
+
+	rnd = random.Random(args.seed)
+	areas = pieceAreas(rnd, args)
+	pieces, quantities = [], []
+	for a in areas:
+		n = rnd.randint(args.vertices[0], args.vertices[1])
+		convex = rnd.random() >= args.nonconvex
+		pieces.append(randomPiece(rnd, n, convex, a * args.scale ** 2,
+		                          args.elongation))
+		quantities.append(rnd.randint(args.quantities[0], args.quantities[1]))
+
+	total = sum(polygonArea(v) * q for v, q in zip(pieces, quantities))
+	plate = plateShape(args, total / args.fill)
+
+	with open(args.output, 'w') as f:
+		if args.output.endswith('.txt'):
+			writeTxt(f, plate, pieces)
+		else:
+			writeXml(f, plate, pieces, quantities, args.angles)
+
+if __name__ == '__main__':
+	main()
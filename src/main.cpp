@@ -21,28 +21,36 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-#include "Algorithm.h"
+#include "Island.h"
+#include "Memory.h"
 #include "Print.h"
 #include "Problem.h"
-#include "Random.h"
-#include "Statistics.h"
+#include "Render.h"
+#include "Solver.h"
+#include "Trace.h"
 #include <boost/program_options.hpp>
 #include <cstdlib>
-#include <ctime>
 #include <iostream>
 
-RNG rng;
-
 using namespace std;
 
-void commandLine(int argc, char** argv) {
+void commandLine(int argc, char** argv, Problem& problem) {
   namespace po = boost::program_options;
+  string logLevelName;
 
   po::options_description desc("Allowed options");
   desc.add_options()("help", "")(
       "in", po::value<string>(&problem.inputFile)->required(), "input file.")(
       "out", po::value<string>(&problem.outputFile)->default_value("out.txt"),
       "output file.")(
+      "svg", po::value<string>(&problem.svgFile),
+      "also draw the layout in this SVG file.")(
+      "pdf", po::value<string>(&problem.pdfFile),
+      "also draw the layout in this PDF file.")(
+      "init", po::value<string>(&problem.initFile),
+      "layout to start from, in the format of the output file. Its pieces "
+      "are matched to those of the instance; the ones that are no longer "
+      "available are dropped, and new ones are added by the search.")(
       "seed", po::value<int>(&problem.randomSeed)->default_value(0),
       "random seed to be used. If 0, a random random seed will used.")(
       "m", po::value<int>(&problem.m)->default_value(1))(
@@ -54,6 +62,12 @@ void commandLine(int argc, char** argv) {
       "phi", po::value<double>(&problem.phi)->default_value(0),
       "the angle step by the pieces may be rotated. If 0, then the "
       "angles specified by the input file are used.")(
+      "coarsephi", po::value<double>(&problem.coarsePhi)->default_value(0),
+      "with --phi, first try rotations in steps of this many degrees, then "
+      "refine around the best ones by halving the step down to phi. If 0, "
+      "every rotation is tried.")(
+      "refine", po::value<int>(&problem.refineAngles)->default_value(3),
+      "rotations refined at each step of --coarsephi.")(
       "supersample",
       po::value<int>(&problem.piecesSuperSample)->default_value(0),
       "a super-sample value of k means that, between every two vertices "
@@ -72,7 +86,22 @@ void commandLine(int argc, char** argv) {
               "performed by default).")(
       "time", po::value<int>(&problem.timeLimitSeconds)->default_value(600),
       "time limit (seconds)")(
-      "silent", "if this option is set, will only output final value")
+      "workbudget", po::value<int64_t>(&problem.workBudget)->default_value(0),
+      "also stop after this many work units (feasibility tests), which, "
+      "unlike time, makes runs with the same seed reproducible on any "
+      "machine. 0 for no limit.")(
+      "target", po::value<double>(&problem.targetUtilization)->default_value(0),
+      "stop once the utilization reaches this percentage. 0 for none.")(
+      "stagnation",
+      po::value<int64_t>(&problem.stagnationIterations)->default_value(0),
+      "stop after this many iterations without improvement. 0 for no "
+      "limit.")(
+      "stagnationtime",
+      po::value<double>(&problem.stagnationSeconds)->default_value(0),
+      "stop after this many seconds without improvement. 0 for no limit.")(
+      "silent", "if this option is set, will only output final value")(
+      "loglevel", po::value<string>(&logLevelName)->default_value("info"),
+      "messages to print: error, warning, info or debug.")
       // 		("iterated", "use proposed iterated greedy approach")
       ("deconstruct",
        po::value<double>(&problem.areaPercentToDeconstruct)->default_value(0.4),
@@ -81,8 +110,46 @@ void commandLine(int argc, char** argv) {
       // 		("alphagreedy", "use alpha greedy approach (it is used by default
       // when" 			" the \'iterated\' option is set")
       ("alpha", po::value<double>(&problem.alpha)->default_value(0.01),
-       "alpha paramter for alpha greedy")("random",
-                                          "use random placement algorithm");
+       "alpha paramter for alpha greedy")(
+      "random", "use random placement algorithm")(
+      "sheets", po::value<int>(&problem.numSheets)->default_value(1),
+      "copies of the plate to nest the pieces on; 0 uses as many as "
+      "needed. Use with --finitepolygons.")(
+      "threads", po::value<int>(&problem.numThreads)->default_value(1),
+      "number of threads of the iterated greedy. With more than one, each "
+      "thread destroys and repairs its own copy of the best layout, and "
+      "improvements are shared; publishing one takes a brief internal lock. "
+      "Which thread's improvement is kept depends on timing, so such runs "
+      "are not reproducible, even with --seed and --workbudget.")(
+      "islands", po::value<int>(&problem.numIslands)->default_value(1),
+      "number of processes that cooperate as islands of one iterated "
+      "greedy search. Start each one with a different --islandid; island "
+      "0 writes the output.")(
+      "islandid", po::value<int>(&problem.islandId)->default_value(0),
+      "index of this process among the islands.")(
+      "islandsocket",
+      po::value<string>(&problem.islandSocket)
+          ->default_value("/tmp/cut-islands.sock"),
+      "Unix domain socket through which islands exchange layouts.")(
+      "migration",
+      po::value<double>(&problem.migrationSeconds)->default_value(10),
+      "seconds between exchanges of the best layouts among islands.")(
+      "checkpoint", po::value<string>(&problem.checkpointFile),
+      "periodically save the state of the iterated greedy to this file, so "
+      "that it can be continued with --resume.")(
+      "checkpointinterval",
+      po::value<double>(&problem.checkpointSeconds)->default_value(300),
+      "seconds between checkpoints.")(
+      "resume", po::value<string>(&problem.resumeFile),
+      "continue the iterated greedy from this checkpoint. The instance and "
+      "options should be those of the interrupted run.")(
+      "trace", po::value<string>(&problem.traceFile),
+      "write a timeline of the run to this file, in Chrome trace-event "
+      "format (open it in chrome://tracing or Perfetto).")(
+      "memory", po::value<string>(&problem.memoryFile),
+      "count heap allocations and bytes by phase of the solver, and the "
+      "peak live bytes and peak RSS; reported with the statistics and "
+      "written to this file as JSON.");
 
   po::variables_map vm;
   try {
@@ -109,21 +176,46 @@ void commandLine(int argc, char** argv) {
 
     assert(problem.optimizeCompaction or problem.optimizeLength or
            problem.optimizeWidth);
-
-    rng.seed(problem.randomSeed ? problem.randomSeed : time(NULL));
+    silentOutput() = problem.silent;
+    int level;
+    if (not parseLogLevel(logLevelName, level))
+      throw po::invalid_option_value(logLevelName);
+    logLevel = level;
 
   } catch (po::error& e) {
-    println("error: ", e.what(), ".");
+    LOG(LogError, "error: ", e.what(), ".");
     print(desc);
     exit(EXIT_FAILURE);
   }
 }
 
 int main(int argc, char** argv) {
-  commandLine(argc, argv);
+  Problem problem;
+  commandLine(argc, argv, problem);
+  if (not problem.memoryFile.empty()) memoryProfiler.open(problem.memoryFile);
   problem.readInstance();
-  problem.timer.restart();
-  alg.run();
-  alg.writeOutput();
-  statistics.printFinalStatistics();
+  Solver solver(move(problem));
+  if (not solver.problem.traceFile.empty())
+    tracer.open(solver.problem.traceFile);
+  solver.solve();
+  tracer.write();
+  if (not islands.enabled() or islands.isCoordinator()) {
+    solver.writeOutput();
+    auto drawings = solver.drawings();
+    /* sheet k of a multi-sheet run goes to name.k.svg */
+    auto name = [&](const string& file, int k) {
+      return drawings.size() == 1 ? file : sheetFileName(file, k);
+    };
+    for (int k = 0; k < (int)drawings.size(); ++k) {
+      if (not solver.problem.svgFile.empty())
+        drawings[k].writeSvg(name(solver.problem.svgFile, k));
+      if (not solver.problem.pdfFile.empty())
+        drawings[k].writePdf(name(solver.problem.pdfFile, k));
+    }
+  }
+  solver.printStatistics();
+  if (memoryProfiler.enabled) {
+    memoryProfiler.print();
+    memoryProfiler.write();
+  }
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "../Render.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* Renders output files of cut: render [--pdf] out1.txt out2.txt ... writes
+ * out1.svg (or out1.pdf), ... next to each input, using all cores. Sheet k
+ * of a multi-sheet output goes to out1.k.svg. */
+int main(int argc, char** argv) {
+  bool pdf = false;
+  vector<string> files;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--pdf") == 0) {
+      pdf = true;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    fprintf(stderr, "usage: %s [--pdf] output files...\n", argv[0]);
+    return 1;
+  }
+
+  atomic<int> next(0);
+  auto worker = [&] {
+    for (int i; (i = next++) < (int)files.size();) {
+      string out = files[i];
+      if (out.size() > 4 and out.compare(out.size() - 4, 4, ".txt") == 0)
+        out.resize(out.size() - 4);
+      out += pdf ? ".pdf" : ".svg";
+      auto sheets = Drawing::readSheets(files[i]);
+      for (int k = 0; k < (int)sheets.size(); ++k) {
+        string name = sheets.size() == 1 ? out : sheetFileName(out, k);
+        if (pdf) {
+          sheets[k].writePdf(name);
+        } else {
+          sheets[k].writeSvg(name);
+        }
+      }
+    }
+  };
+  int numThreads = min<int>(max(1u, thread::hardware_concurrency()),
+                            files.size());
+  vector<thread> threads;
+  for (int i = 0; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  for (auto& t : threads)
+    t.join();
+}